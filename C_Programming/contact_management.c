@@ -2,17 +2,72 @@
  * Project : Contact Management System
  * Purpose : Store, search, update and manage contacts
  * Author  : Suresh Pujari
+ * Build   : gcc contact_management.c -o contact_management -pthread
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "phone_utils.h"
 
 #define MAX_NAME_LEN 30
 #define MAX_PHONE_LEN 15
 #define INITIAL_CAPACITY 10
+#define INDEX_INITIAL_SLOTS 32
+#define INDEX_EMPTY -1
+#define INDEX_DELETED -2
+#define GRAM_INITIAL_SLOTS 1024
+#define GRAM_PHONE_TAG (1u << 24)
+#define GRAM_MAX (MAX_NAME_LEN + 2)
+#define TOP_K 10
+#define COMPACT_MIN_TOMBSTONES 16
+#define COMPACT_RATIO 4 /* compact once 1 in COMPACT_RATIO slots is dead */
 #define DATA_FILE "contacts.dat"
+#define TEMP_FILE "contacts.dat.tmp"
+#define SNAPSHOT_MAGIC "CNTS"
+#define SNAPSHOT_VERSION 4 /* 1: no count/nextId checksum, 2: no headerSum, 3: rows */
+#define JOURNAL_FILE "contacts.wal"
+#define JOURNAL_OLD_FILE "contacts.wal.old" /* set aside while a server snapshot saves */
+#define JOURNAL_GROUP_SIZE 64       /* records per write + fsync */
+#define JOURNAL_CHECKPOINT_MIN 4096 /* records before folding into a snapshot */
+#define IO_BUFFER_SIZE (1 << 20)
+#define ARENA_INITIAL 4096
+#define ARENA_DEAD_PER_SLOT 4       /* dead name bytes per slot before a repack */
+#define PHONE_SPILLED (1ull << 63) /* number kept as text in the name arena */
+#define PHONE_VALUE_MASK ((1ull << PHONE_KEY_SHIFT) - 1)
+#define IMPORT_BATCH 4096
+#define PAGE_SIZE 20
+#define COMMAND_LEN 128
+#define SHARD_BITS 4
+#define SHARD_COUNT (1 << SHARD_BITS)
+#define SERVER_SOCKET "contacts.sock"
+#define SERVER_BUFFER (64 * 1024)
+#define SERVER_MAX_CLIENTS 256
+#define LOAD_PIPELINE 32 /* requests a load client keeps in flight */
+#define LOAD_WRITE_EVERY 10 /* one add per this many requests */
+#define DEDUP_WINDOW 64       /* block neighbours each contact is compared with */
+#define DEDUP_SUFFIX_DIGITS 7 /* shortest number matched against a longer one */
+#define DEDUP_MAX_THREADS 16
+#define DEDUP_SHOW 20
+#define ALIGN_UP(n, a) (((n) + (a) - 1) / (a) * (a))
+#define ROW_HEADER_SIZE offsetof(SnapshotHeader, arenaSize) /* versions 1-3 */
+#define COLUMN_ROW_SIZE (sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(int) + sizeof(uint8_t))
 
 typedef enum
 {
@@ -28,261 +83,4402 @@ typedef struct
   char phone[MAX_PHONE_LEN];
 } Contact;
 
+/*
+ * contacts.dat: header, then the columns of ContactList for count contacts
+ * (numbers, nameHash, nameAt, ids, nameLen) and the name arena. The file is
+ * mapped copy-on-write and used in place, so loading does not copy or
+ * parse the contacts. Only headerSum is checked at load; checksum is
+ * checked by the first pass that reads every contact. Versions 1-3 held
+ * Contact records, padding to int alignment and the ids behind a header
+ * without arenaSize; they are converted to columns on load.
+ */
+typedef struct
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t nextId;
+  uint32_t recordSize; /* COLUMN_ROW_SIZE; sizeof(Contact) up to version 3 */
+  uint32_t headerSum;  /* low half of FNV-1a over the other header fields */
+  uint64_t checksum;   /* FNV-1a over count, nextId and the contacts */
+  uint64_t arenaSize;
+} SnapshotHeader;
+
+/*
+ * contacts.wal: fixed-size records appended after every change since the
+ * last snapshot. Each one carries the contact id and full contents, so
+ * replaying a record that the snapshot already holds is harmless.
+ */
+typedef enum
+{
+  JOURNAL_ADD = 1,
+  JOURNAL_UPDATE,
+  JOURNAL_DELETE
+} JournalOp;
+
+typedef struct
+{
+  uint32_t op;
+  int32_t id;
+  Contact contact;
+  char pad[3];
+  uint32_t checksum; /* low half of FNV-1a over everything above */
+} JournalRecord;
+
+typedef struct
+{
+  int fd; /* -1 while replaying or when journaling is off */
+  int pendingCount;
+  long records; /* committed since the last checkpoint */
+  bool autoCheckpoint; /* off while the contacts live elsewhere (server shards) */
+  unsigned long groups; /* group writes attempted */
+  unsigned long lastFailed; /* groups as of the last one that failed */
+  JournalRecord pending[JOURNAL_GROUP_SIZE];
+} Journal;
+
+/*
+ * Open-addressing hash -> slot in ContactList. One table is keyed
+ * by case-folded name, the other by phoneKey() for caller-ID lookups.
+ */
+typedef struct
+{
+  unsigned int hash;
+  int index;
+} IndexSlot;
+
+typedef struct
+{
+  IndexSlot *slots;
+  int capacity; /* always a power of two */
+  int used;     /* live + deleted slots */
+} NameIndex;
+
+/* Trigram posting lists over case-folded names and phones */
+typedef struct
+{
+  unsigned int gram; /* 0 marks an empty slot */
+  int count;
+  int capacity;
+  int *positions;
+} Posting;
+
+typedef struct
+{
+  Posting *slots;
+  int capacity; /* always a power of two */
+  int used;
+  int stale; /* contacts re-indexed by update whose old postings linger */
+} GramIndex;
+
+typedef enum
+{
+  MATCH_EXACT,
+  MATCH_PREFIX,
+  MATCH_SUBSTRING,
+  MATCH_FUZZY
+} MatchKind;
+
+typedef struct
+{
+  int pos;
+  MatchKind kind;
+} Match;
+
+/*
+ * Slots [0, count) of the columns are either live or tombstones. Deleting
+ * only marks the slot and pushes it on freeSlots for the next add to reuse;
+ * compactList() squeezes the tombstones out once they pile up. Contacts
+ * are numbered by a stable id that is saved with them and never reused.
+ *
+ * Each field is a column of its own, so a pass over one field reads only
+ * that field: a number is packed into one word (packPhone()), and a name is
+ * its hash and an offset into one arena of NUL-terminated names, where
+ * equal names share one copy. Contact is only the value passed in and out.
+ */
+typedef enum
+{
+  VIEW_ID,
+  VIEW_NAME,
+  VIEW_PHONE,
+  VIEW_COUNT
+} ViewOrder;
+
+/* Live slots in some order, valid while version matches the list's */
+typedef struct
+{
+  int *slots;
+  int count;
+  unsigned int version;
+  bool built;
+} SortedView;
+
 typedef struct
 {
-  Contact *data;
+  uint64_t *numbers;  /* packPhone() of each number */
+  uint32_t *nameHash; /* hashName() of each name */
+  uint32_t *nameAt;   /* arena offset of each name */
+  uint8_t *nameLen;
+  int *ids;       /* slot -> contact id, 0 for a tombstone */
+  int *freeSlots; /* stack of tombstoned slots */
+  int *slotOf;    /* contact id -> slot, -1 once deleted */
   int count;
   int capacity;
+  int tombstones;
+  int nextId;
+  int idCapacity;
+  char *arena;
+  size_t arenaUsed;
+  size_t arenaCapacity;
+  size_t arenaDead; /* freed by updates and deletes; shared names overcount */
+  void *mapBase; /* columns and arena live in this mapping until they grow */
+  size_t mapLen;
+  bool indexed; /* slotOf and both indexes are built on first use */
+  NameIndex index;
+  NameIndex phones;
+  GramIndex grams;
+  Journal journal;
+  unsigned int version; /* bumped by every change that moves or edits a slot */
+  SortedView views[VIEW_COUNT];
 } ContactList;
 
-/* ===================== Function Prototypes ===================== */
+/* ===================== Function Prototypes ===================== */
+
+void initList(ContactList *);
+void freeList(ContactList *);
+void loadFromFile(ContactList *);
+bool saveToFile(const ContactList *);
+uint64_t checksum64(uint64_t, const void *, size_t);
+void verifySnapshot(const ContactList *);
+void addContact(ContactList *);
+void displayContacts(ContactList *);
+const SortedView *sortedView(ContactList *, ViewOrder);
+size_t renderPage(const ContactList *, const SortedView *, int, int, char *);
+void searchContact(ContactList *);
+void updateContact(ContactList *);
+void deleteContact(ContactList *);
+const char *nameOf(const ContactList *, int);
+const char *phoneOf(const ContactList *, int, char *);
+Contact contactAt(const ContactList *, int);
+void storeContact(ContactList *, int, const Contact *);
+int insertContact(ContactList *, const Contact *);
+void replaceContact(ContactList *, int, const Contact *);
+void removeContact(ContactList *, int);
+void smartSearch(ContactList *);
+void callerIdLookup(ContactList *);
+int rankedSearch(const ContactList *, const char *, Match *, int);
+bool validatePhone(const char *);
+void resizeList(ContactList *);
+void reserveList(ContactList *, int);
+int allocSlot(ContactList *);
+void assignId(ContactList *, int);
+void setId(ContactList *, int, int);
+int slotForId(const ContactList *, int);
+void compactList(ContactList *);
+void ensureIndexes(ContactList *);
+unsigned int hashName(const char *);
+void indexInit(NameIndex *, int);
+void indexInsert(ContactList *, int);
+void indexRemove(ContactList *, int);
+int indexFind(const ContactList *, const char *);
+int phoneFind(const ContactList *, const char *);
+void indexRebuild(ContactList *);
+void gramInit(GramIndex *, int);
+void gramFree(GramIndex *);
+void gramAdd(ContactList *, int);
+void gramRebuild(ContactList *);
+void journalOpen(ContactList *);
+void journalReplay(ContactList *);
+void journalLog(ContactList *, JournalOp, int, const Contact *);
+bool journalCommit(ContactList *);
+bool journalClose(ContactList *);
+bool journalSetAside(ContactList *);
+bool journalRejoin(ContactList *);
+bool checkpoint(ContactList *);
+bool importContacts(ContactList *, const char *);
+bool exportContacts(const ContactList *, const char *);
+bool runBatch(ContactList *, const char *);
+bool runServer(ContactList *, const char *);
+bool runLoad(const char *, int, long);
+void dedupContacts(ContactList *, bool);
+bool runChecks(void);
+void clearInputBuffer(void);
+void showMenu(void);
+
+/* ===================== Main ===================== */
+
+int main(int argc, char *argv[])
+{
+  ContactList list;
+  int choice;
+
+  /* the load generator only talks to a running server; it never opens the files */
+  if ((argc == 4 || argc == 5) && strcmp(argv[1], "loadgen") == 0)
+    return runLoad(argc == 5 ? argv[4] : SERVER_SOCKET, atoi(argv[2]), atol(argv[3]))
+               ? 0
+               : EXIT_FAILURE;
+  /* the self-check works on its own files in a scratch directory */
+  if (argc == 2 && strcmp(argv[1], "check") == 0)
+    return runChecks() ? 0 : EXIT_FAILURE;
+
+  initList(&list);
+  loadFromFile(&list);
+  journalReplay(&list);
+
+  /* bulk modes: contact_management import|export <file.csv|file.vcf> */
+  if (argc == 3 && strcmp(argv[1], "import") == 0)
+  {
+    bool ok = importContacts(&list, argv[2]);
+    ok = checkpoint(&list) && ok;
+    freeList(&list);
+    return ok ? 0 : EXIT_FAILURE;
+  }
+  if (argc == 3 && strcmp(argv[1], "export") == 0)
+  {
+    bool ok = exportContacts(&list, argv[2]);
+    freeList(&list);
+    return ok ? 0 : EXIT_FAILURE;
+  }
+  if ((argc == 2 || argc == 3) && strcmp(argv[1], "batch") == 0)
+  {
+    journalOpen(&list);
+    bool ok = runBatch(&list, argc == 3 ? argv[2] : NULL);
+    ok = journalClose(&list) && ok;
+    freeList(&list);
+    return ok ? 0 : EXIT_FAILURE;
+  }
+  if ((argc == 2 || (argc == 3 && strcmp(argv[2], "merge") == 0)) &&
+      strcmp(argv[1], "dedup") == 0)
+  {
+    dedupContacts(&list, argc == 3);
+    bool ok = argc == 2 || checkpoint(&list);
+    freeList(&list);
+    return ok ? 0 : EXIT_FAILURE;
+  }
+  if ((argc == 2 || argc == 3) && strcmp(argv[1], "serve") == 0)
+  {
+    bool ok = runServer(&list, argc == 3 ? argv[2] : SERVER_SOCKET);
+    freeList(&list);
+    return ok ? 0 : EXIT_FAILURE;
+  }
+  if (argc != 1)
+  {
+    printf("Usage: %s [import|export <file.csv|file.vcf> |"
+           " batch [commands.txt] | dedup [merge] | serve [socket] |"
+           " loadgen <clients> <requests> [socket] | check]\n",
+           argv[0]);
+    freeList(&list);
+    return EXIT_FAILURE;
+  }
+
+  journalOpen(&list);
+
+  while (1)
+  {
+    /* everything done since the last prompt shares one fsync */
+    journalCommit(&list);
+    showMenu();
+    if (scanf("%d", &choice) != 1)
+    {
+      clearInputBuffer();
+      continue;
+    }
+    clearInputBuffer();
+
+    switch (choice)
+    {
+    case 1:
+      addContact(&list);
+      break;
+    case 2:
+      displayContacts(&list);
+      break;
+    case 3:
+      searchContact(&list);
+      break;
+    case 4:
+      updateContact(&list);
+      break;
+    case 5:
+      deleteContact(&list);
+      break;
+    case 6:
+      if (journalClose(&list))
+        printf("Exiting... Data saved.\n");
+      else
+        printf("Exiting... Some changes could not be saved.\n");
+      freeList(&list);
+      return 0;
+    case 7:
+      smartSearch(&list);
+      break;
+    case 8:
+      callerIdLookup(&list);
+      break;
+    default:
+      printf("Invalid option!\n");
+    }
+  }
+}
+
+/* ===================== Core Functions ===================== */
+
+void initList(ContactList *list)
+{
+  list->count = 0;
+  list->tombstones = 0;
+  list->capacity = INITIAL_CAPACITY;
+  list->nextId = 1;
+  list->idCapacity = INITIAL_CAPACITY;
+  list->arena = NULL;
+  list->arenaUsed = 0;
+  list->arenaCapacity = 0;
+  list->arenaDead = 0;
+  list->mapBase = NULL;
+  list->mapLen = 0;
+  list->indexed = true;
+  list->journal.fd = -1;
+  list->journal.pendingCount = 0;
+  list->journal.records = 0;
+  list->journal.autoCheckpoint = true;
+  list->journal.groups = 0;
+  list->journal.lastFailed = 0;
+  list->version = 0;
+  memset(list->views, 0, sizeof(list->views));
+  list->numbers = (uint64_t *)malloc(sizeof(uint64_t) * list->capacity);
+  list->nameHash = (uint32_t *)malloc(sizeof(uint32_t) * list->capacity);
+  list->nameAt = (uint32_t *)malloc(sizeof(uint32_t) * list->capacity);
+  list->nameLen = (uint8_t *)malloc(sizeof(uint8_t) * list->capacity);
+  list->ids = (int *)malloc(sizeof(int) * list->capacity);
+  list->freeSlots = (int *)malloc(sizeof(int) * list->capacity);
+  list->slotOf = (int *)malloc(sizeof(int) * list->idCapacity);
+  if (!list->numbers || !list->nameHash || !list->nameAt || !list->nameLen || !list->ids ||
+      !list->freeSlots || !list->slotOf)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  indexInit(&list->index, INDEX_INITIAL_SLOTS);
+  indexInit(&list->phones, INDEX_INITIAL_SLOTS);
+  gramInit(&list->grams, GRAM_INITIAL_SLOTS);
+}
+
+void freeList(ContactList *list)
+{
+  for (int v = 0; v < VIEW_COUNT; v++)
+    free(list->views[v].slots);
+  gramFree(&list->grams);
+  free(list->index.slots);
+  free(list->phones.slots);
+  free(list->slotOf);
+  free(list->freeSlots);
+  if (list->mapBase)
+  {
+    munmap(list->mapBase, list->mapLen);
+  }
+  else
+  {
+    free(list->ids);
+    free(list->numbers);
+    free(list->nameHash);
+    free(list->nameAt);
+    free(list->nameLen);
+    free(list->arena);
+  }
+}
+
+/* Moves the columns and the arena from the file mapping onto the heap */
+static void unmapList(ContactList *list, int capacity)
+{
+  size_t arenaCapacity = list->arenaUsed > ARENA_INITIAL ? list->arenaUsed : ARENA_INITIAL;
+  uint64_t *numbers = (uint64_t *)malloc(sizeof(uint64_t) * capacity);
+  uint32_t *nameHash = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+  uint32_t *nameAt = (uint32_t *)malloc(sizeof(uint32_t) * capacity);
+  uint8_t *nameLen = (uint8_t *)malloc(sizeof(uint8_t) * capacity);
+  int *ids = (int *)malloc(sizeof(int) * capacity);
+  char *arena = (char *)malloc(arenaCapacity);
+  if (!numbers || !nameHash || !nameAt || !nameLen || !ids || !arena)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(numbers, list->numbers, sizeof(uint64_t) * list->count);
+  memcpy(nameHash, list->nameHash, sizeof(uint32_t) * list->count);
+  memcpy(nameAt, list->nameAt, sizeof(uint32_t) * list->count);
+  memcpy(nameLen, list->nameLen, sizeof(uint8_t) * list->count);
+  memcpy(ids, list->ids, sizeof(int) * list->count);
+  memcpy(arena, list->arena, list->arenaUsed);
+  munmap(list->mapBase, list->mapLen);
+  list->mapBase = NULL;
+  list->numbers = numbers;
+  list->nameHash = nameHash;
+  list->nameAt = nameAt;
+  list->nameLen = nameLen;
+  list->ids = ids;
+  list->arena = arena;
+  list->arenaCapacity = arenaCapacity;
+}
+
+void resizeList(ContactList *list)
+{
+  reserveList(list, list->capacity + 1);
+}
+
+/* Grows geometrically to hold at least needed slots, in one step */
+void reserveList(ContactList *list, int needed)
+{
+  if (needed <= list->capacity)
+    return;
+  int capacity = list->capacity * 2;
+  if (capacity < INITIAL_CAPACITY)
+    capacity = INITIAL_CAPACITY;
+  if (capacity < needed)
+    capacity = needed;
+
+  int *freeSlots = (int *)realloc(list->freeSlots, sizeof(int) * capacity);
+  if (!freeSlots)
+  {
+    printf("Memory resize failed\n");
+    return;
+  }
+  list->freeSlots = freeSlots;
+
+  if (list->mapBase)
+  {
+    unmapList(list, capacity);
+    list->capacity = capacity;
+    return;
+  }
+
+  /* a column that grew before another failed just keeps its spare room */
+  uint64_t *numbers = (uint64_t *)realloc(list->numbers, sizeof(uint64_t) * capacity);
+  if (numbers)
+    list->numbers = numbers;
+  uint32_t *nameHash = (uint32_t *)realloc(list->nameHash, sizeof(uint32_t) * capacity);
+  if (nameHash)
+    list->nameHash = nameHash;
+  uint32_t *nameAt = (uint32_t *)realloc(list->nameAt, sizeof(uint32_t) * capacity);
+  if (nameAt)
+    list->nameAt = nameAt;
+  uint8_t *nameLen = (uint8_t *)realloc(list->nameLen, sizeof(uint8_t) * capacity);
+  if (nameLen)
+    list->nameLen = nameLen;
+  int *ids = (int *)realloc(list->ids, sizeof(int) * capacity);
+  if (ids)
+    list->ids = ids;
+  if (!numbers || !nameHash || !nameAt || !nameLen || !ids)
+  {
+    printf("Memory resize failed\n");
+    return;
+  }
+  list->capacity = capacity;
+}
+
+/* Reuses a tombstoned slot when there is one, otherwise appends */
+int allocSlot(ContactList *list)
+{
+  if (list->tombstones > 0)
+    return list->freeSlots[--list->tombstones];
+
+  if (list->count == list->capacity)
+    resizeList(list);
+  if (list->count == list->capacity)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return list->count++;
+}
+
+/* Binds slot to a given id, e.g. one recorded in the journal */
+void setId(ContactList *list, int slot, int id)
+{
+  if (id >= list->idCapacity)
+  {
+    int capacity = list->idCapacity;
+    while (capacity <= id)
+      capacity *= 2;
+    int *temp = (int *)realloc(list->slotOf, sizeof(int) * capacity);
+    if (!temp)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    list->slotOf = temp;
+    list->idCapacity = capacity;
+  }
+  for (; list->nextId <= id; list->nextId++)
+    list->slotOf[list->nextId] = -1;
+  list->ids[slot] = id;
+  list->slotOf[id] = slot;
+}
+
+/* Gives the contact in slot the next stable id */
+void assignId(ContactList *list, int slot)
+{
+  setId(list, slot, list->nextId);
+}
+
+int slotForId(const ContactList *list, int id)
+{
+  if (id < 1 || id >= list->nextId)
+    return -1;
+  return list->slotOf[id];
+}
+
+/* Copies text and a NUL into the arena; returns its offset */
+static uint32_t arenaAppend(ContactList *list, const char *text, size_t len)
+{
+  if (list->mapBase)
+    unmapList(list, list->capacity);
+  if (list->arenaUsed + len + 1 > UINT32_MAX)
+  {
+    printf("Too many names to store\n");
+    exit(EXIT_FAILURE);
+  }
+  if (list->arenaUsed + len + 1 > list->arenaCapacity)
+  {
+    size_t capacity = list->arenaCapacity ? list->arenaCapacity * 2 : ARENA_INITIAL;
+    while (capacity < list->arenaUsed + len + 1)
+      capacity *= 2;
+    char *temp = (char *)realloc(list->arena, capacity);
+    if (!temp)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    list->arena = temp;
+    list->arenaCapacity = capacity;
+  }
+  memcpy(list->arena + list->arenaUsed, text, len);
+  list->arena[list->arenaUsed + len] = '\0';
+  list->arenaUsed += len + 1;
+  return (uint32_t)(list->arenaUsed - len - 1);
+}
+
+/*
+ * A number of digits packs the way phoneKey() encodes it, digit count above
+ * the value, so the phone index and the phone order use the word as is.
+ * Anything else is kept as text in the arena, marked PHONE_SPILLED.
+ */
+static uint64_t packPhone(ContactList *list, const char *phone)
+{
+  size_t len = strnlen(phone, MAX_PHONE_LEN - 1);
+  if (phone[len] == '\0' && phoneIsDigits(phone))
+  {
+    uint64_t value = 0;
+    for (size_t i = 0; i < len; i++)
+      value = value * 10 + (uint64_t)(phone[i] - '0');
+    return (uint64_t)len << PHONE_KEY_SHIFT | value;
+  }
+  return PHONE_SPILLED | (uint64_t)len << PHONE_KEY_SHIFT | arenaAppend(list, phone, len);
+}
+
+static int packedLen(uint64_t packed)
+{
+  return (int)(packed >> PHONE_KEY_SHIFT & 0x7f);
+}
+
+/* phoneKey() of the number in slot */
+static uint64_t phoneKeyOf(const ContactList *list, int slot)
+{
+  uint64_t packed = list->numbers[slot];
+  if (packed & PHONE_SPILLED)
+    return phoneKey(list->arena + (packed & PHONE_VALUE_MASK));
+  return packed;
+}
+
+const char *nameOf(const ContactList *list, int slot)
+{
+  return list->arena + list->nameAt[slot];
+}
+
+/* Writes the number in slot into buf (MAX_PHONE_LEN bytes) and returns it */
+const char *phoneOf(const ContactList *list, int slot, char *buf)
+{
+  uint64_t packed = list->numbers[slot], value = packed & PHONE_VALUE_MASK;
+  int len = packedLen(packed);
+  if (packed & PHONE_SPILLED)
+  {
+    memcpy(buf, list->arena + value, len);
+  }
+  else
+  {
+    for (int i = len - 1; i >= 0; i--, value /= 10)
+      buf[i] = (char)('0' + value % 10);
+  }
+  buf[len] = '\0';
+  return buf;
+}
+
+Contact contactAt(const ContactList *list, int slot)
+{
+  Contact c;
+  memset(&c, 0, sizeof(c));
+  memcpy(c.name, nameOf(list, slot), list->nameLen[slot]);
+  phoneOf(list, slot, c.phone);
+  return c;
+}
+
+/*
+ * Writes c into the columns of slot. A name equal to one the index already
+ * holds shares its bytes; while a list is being loaded there is no index,
+ * so every name is stored and the next repack or save shares them.
+ */
+void storeContact(ContactList *list, int slot, const Contact *c)
+{
+  size_t len = strnlen(c->name, MAX_NAME_LEN - 1);
+  int other = list->indexed ? indexFind(list, c->name) : -1;
+  uint32_t at = other != -1 && list->nameLen[other] == len &&
+                        memcmp(nameOf(list, other), c->name, len) == 0
+                    ? list->nameAt[other]
+                    : arenaAppend(list, c->name, len);
+  uint64_t phone = packPhone(list, c->phone);
+
+  /* appending may have moved the columns off the file mapping */
+  list->numbers[slot] = phone;
+  list->nameHash[slot] = hashName(c->name);
+  list->nameAt[slot] = at;
+  list->nameLen[slot] = (uint8_t)len;
+}
+
+/*
+ * Copies the names and spilled numbers of live slots into a fresh arena,
+ * each distinct name once, and sets at and numbers of every slot to match.
+ * They may be the list's own columns. Returns the arena; *used its size.
+ */
+static char *internNames(const ContactList *list, uint32_t *at, uint64_t *numbers, size_t *used)
+{
+  int live = list->count - list->tombstones;
+  int size = 16;
+  while (size < live * 2)
+    size *= 2;
+  int *first = (int *)malloc(sizeof(int) * size);
+  char *fresh = (char *)malloc(list->arenaUsed + 1);
+  if (!first || !fresh)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < size; i++)
+    first[i] = -1;
+
+  size_t n = 0;
+  fresh[0] = '\0';
+  for (int i = 0; i < list->count; i++)
+  {
+    if (list->ids[i] == 0)
+    {
+      at[i] = 0;
+      numbers[i] = 0;
+      continue;
+    }
+    const char *name = list->arena + list->nameAt[i];
+    size_t len = list->nameLen[i];
+    unsigned int s = list->nameHash[i] & (unsigned int)(size - 1);
+    while (first[s] != -1)
+    {
+      int o = first[s];
+      if (list->nameHash[o] == list->nameHash[i] && list->nameLen[o] == len &&
+          memcmp(fresh + at[o], name, len) == 0)
+        break;
+      s = (s + 1) & (unsigned int)(size - 1);
+    }
+    if (first[s] == -1)
+    {
+      first[s] = i;
+      memcpy(fresh + n, name, len + 1);
+      at[i] = (uint32_t)n;
+      n += len + 1;
+    }
+    else
+    {
+      at[i] = at[first[s]];
+    }
+
+    uint64_t packed = list->numbers[i];
+    if (packed & PHONE_SPILLED)
+    {
+      size_t plen = packedLen(packed);
+      memcpy(fresh + n, list->arena + (packed & PHONE_VALUE_MASK), plen + 1);
+      packed = (packed & ~PHONE_VALUE_MASK) | n;
+      n += plen + 1;
+    }
+    numbers[i] = packed;
+  }
+  free(first);
+  *used = n;
+  return fresh;
+}
+
+/* Drops the arena bytes no live slot uses once enough of them pile up */
+static void reclaimArena(ContactList *list)
+{
+  if (list->arenaDead * 2 <= list->arenaUsed ||
+      list->arenaDead < (size_t)list->count * ARENA_DEAD_PER_SLOT)
+    return;
+  if (list->mapBase)
+    unmapList(list, list->capacity);
+  size_t used;
+  char *arena = internNames(list, list->nameAt, list->numbers, &used);
+  free(list->arena);
+  list->arenaCapacity = list->arenaUsed + 1;
+  list->arena = arena;
+  list->arenaUsed = used;
+  list->arenaDead = 0;
+}
+
+/* Counts the arena bytes of slot as dead before it is overwritten or deleted */
+static void releaseSlot(ContactList *list, int slot)
+{
+  list->arenaDead += list->nameLen[slot] + 1u;
+  if (list->numbers[slot] & PHONE_SPILLED)
+    list->arenaDead += packedLen(list->numbers[slot]) + 1u;
+}
+
+/* Slides live contacts over the tombstones; ids stay as they are */
+void compactList(ContactList *list)
+{
+  int live = 0;
+  for (int i = 0; i < list->count; i++)
+  {
+    if (list->ids[i] == 0)
+      continue;
+    list->numbers[live] = list->numbers[i];
+    list->nameHash[live] = list->nameHash[i];
+    list->nameAt[live] = list->nameAt[i];
+    list->nameLen[live] = list->nameLen[i];
+    list->ids[live] = list->ids[i];
+    list->slotOf[list->ids[live]] = live;
+    live++;
+  }
+  list->count = live;
+  list->tombstones = 0;
+  list->version++;
+  indexRebuild(list);
+  gramRebuild(list);
+}
+
+/* Builds id -> slot and both search indexes for a freshly loaded list */
+void ensureIndexes(ContactList *list)
+{
+  if (list->indexed)
+    return;
+  verifySnapshot(list);
+
+  int *temp = (int *)realloc(list->slotOf, sizeof(int) * list->nextId);
+  if (!temp)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  list->slotOf = temp;
+  list->idCapacity = list->nextId;
+  for (int id = 0; id < list->nextId; id++)
+    list->slotOf[id] = -1;
+  for (int i = 0; i < list->count; i++)
+  {
+    int id = list->ids[i];
+    if (id < 0 || id >= list->nextId)
+    {
+      printf("%s has an invalid contact id\n", DATA_FILE);
+      exit(EXIT_FAILURE);
+    }
+    if (id != 0)
+      list->slotOf[id] = i;
+  }
+
+  indexRebuild(list);
+  gramRebuild(list);
+  list->indexed = true;
+}
+
+/* Stores c under a fresh id and returns that id */
+int insertContact(ContactList *list, const Contact *c)
+{
+  ensureIndexes(list);
+  int slot = allocSlot(list);
+  storeContact(list, slot, c);
+  assignId(list, slot);
+  list->version++;
+  indexInsert(list, slot);
+  gramAdd(list, slot);
+  journalLog(list, JOURNAL_ADD, list->ids[slot], c);
+  return list->ids[slot];
+}
+
+/* Overwrites the live contact in slot, keeping its id */
+void replaceContact(ContactList *list, int slot, const Contact *c)
+{
+  indexRemove(list, slot);
+  releaseSlot(list, slot);
+  storeContact(list, slot, c);
+  list->version++;
+  indexInsert(list, slot);
+  gramAdd(list, slot);
+  list->grams.stale++;
+  if (list->grams.stale > list->count)
+    gramRebuild(list);
+  journalLog(list, JOURNAL_UPDATE, list->ids[slot], c);
+  reclaimArena(list);
+}
+
+/* Tombstones the live contact in slot */
+void removeContact(ContactList *list, int slot)
+{
+  int id = list->ids[slot];
+  indexRemove(list, slot);
+  releaseSlot(list, slot);
+  list->ids[slot] = 0;
+  list->slotOf[id] = -1;
+  list->freeSlots[list->tombstones++] = slot;
+  list->grams.stale++;
+  list->version++;
+  journalLog(list, JOURNAL_DELETE, id, NULL);
+
+  if (list->tombstones >= COMPACT_MIN_TOMBSTONES &&
+      list->tombstones * COMPACT_RATIO > list->count)
+    compactList(list);
+  reclaimArena(list);
+}
+
+void addContact(ContactList *list)
+{
+  Contact c;
+  memset(&c, 0, sizeof(c));
+
+  printf("Enter Name : ");
+  fgets(c.name, MAX_NAME_LEN, stdin);
+  c.name[strcspn(c.name, "\n")] = '\0';
+
+  do
+  {
+    printf("Enter Phone : ");
+    fgets(c.phone, MAX_PHONE_LEN, stdin);
+    c.phone[strcspn(c.phone, "\n")] = '\0';
+  } while (!validatePhone(c.phone));
+
+  insertContact(list, &c);
+  printf("Contact added successfully!\n");
+}
+
+/* Shows one PAGE_SIZE window at a time of the chosen sorted view */
+void displayContacts(ContactList *list)
+{
+  if (list->count == list->tombstones)
+  {
+    printf("No contacts available.\n");
+    return;
+  }
+
+  int order = 1, page = 1;
+  printf("Sort by (1) Number (2) Name (3) Phone : ");
+  if (scanf("%d", &order) != 1 || order < 1 || order > VIEW_COUNT)
+    order = 1;
+  clearInputBuffer();
+
+  const SortedView *view = sortedView(list, (ViewOrder)(order - 1));
+  int pages = (view->count + PAGE_SIZE - 1) / PAGE_SIZE;
+  char *buf = (char *)malloc((size_t)PAGE_SIZE * (MAX_NAME_LEN + MAX_PHONE_LEN + 32));
+  if (!buf)
+  {
+    printf("Memory allocation failed\n");
+    return;
+  }
+
+  while (page >= 1 && page <= pages)
+  {
+    printf("\n------ Contact List (page %d of %d) ------\n", page, pages);
+    fflush(stdout);
+    size_t len = renderPage(list, view, (page - 1) * PAGE_SIZE, PAGE_SIZE, buf);
+    fwrite(buf, 1, len, stdout);
+
+    if (pages == 1)
+      break;
+    printf("Page number (0 to go back) : ");
+    if (scanf("%d", &page) != 1)
+      page = 0;
+    clearInputBuffer();
+  }
+  free(buf);
+}
+
+/* ===================== Sorted Views ===================== */
+
+static int compareSlots(const ContactList *list, ViewOrder order, int a, int b)
+{
+  int r = 0;
+  if (order == VIEW_NAME)
+  {
+    r = strcasecmp(nameOf(list, a), nameOf(list, b));
+  }
+  else if (order == VIEW_PHONE)
+  {
+    /* digit strings: shorter is smaller, then plain byte order, which is
+       just how their packed words compare */
+    uint64_t pa = list->numbers[a], pb = list->numbers[b];
+    if ((pa | pb) & PHONE_SPILLED)
+    {
+      char ta[MAX_PHONE_LEN], tb[MAX_PHONE_LEN];
+      size_t la = strlen(phoneOf(list, a, ta)), lb = strlen(phoneOf(list, b, tb));
+      r = la != lb ? (la < lb ? -1 : 1) : strcmp(ta, tb);
+    }
+    else
+    {
+      r = pa < pb ? -1 : pa > pb;
+    }
+  }
+  if (r == 0)
+    r = list->ids[a] < list->ids[b] ? -1 : list->ids[a] > list->ids[b];
+  return r;
+}
+
+/* Bottom-up merge sort; qsort has no way to pass the list along */
+static void sortSlots(const ContactList *list, ViewOrder order, int *slots, int n)
+{
+  int *tmp = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+  if (!tmp)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  int *from = slots, *to = tmp;
+  for (int width = 1; width < n; width *= 2)
+  {
+    for (int lo = 0; lo < n; lo += 2 * width)
+    {
+      int mid = lo + width < n ? lo + width : n;
+      int hi = lo + 2 * width < n ? lo + 2 * width : n;
+      int i = lo, j = mid, k = lo;
+      while (i < mid && j < hi)
+        to[k++] = compareSlots(list, order, from[i], from[j]) <= 0 ? from[i++] : from[j++];
+      while (i < mid)
+        to[k++] = from[i++];
+      while (j < hi)
+        to[k++] = from[j++];
+    }
+    int *t = from;
+    from = to;
+    to = t;
+  }
+  if (from != slots)
+    memcpy(slots, from, sizeof(int) * n);
+  free(tmp);
+}
+
+/* Returns the cached view, re-sorting only if the list changed since */
+const SortedView *sortedView(ContactList *list, ViewOrder order)
+{
+  SortedView *view = &list->views[order];
+  if (view->built && view->version == list->version)
+    return view;
+  verifySnapshot(list);
+
+  int *slots = (int *)realloc(view->slots, sizeof(int) * (list->count > 0 ? list->count : 1));
+  if (!slots)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  view->slots = slots;
+  view->count = 0;
+  for (int i = 0; i < list->count; i++)
+    if (list->ids[i] != 0)
+      view->slots[view->count++] = i;
+
+  sortSlots(list, order, view->slots, view->count);
+  view->version = list->version;
+  view->built = true;
+  return view;
+}
+
+static char *appendInt(char *out, int value)
+{
+  char digits[12];
+  int n = 0;
+  do
+  {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (n > 0)
+    *out++ = digits[--n];
+  return out;
+}
+
+static char *appendText(char *out, const char *text, size_t max)
+{
+  size_t len = strnlen(text, max);
+  memcpy(out, text, len);
+  return out + len;
+}
+
+/*
+ * Formats rows [first, first + n) of view as "id. name | phone" lines into
+ * buf, which must hold n * (MAX_NAME_LEN + MAX_PHONE_LEN + 32) bytes.
+ * Returns the number of bytes written.
+ */
+size_t renderPage(const ContactList *list, const SortedView *view,
+                  int first, int n, char *buf)
+{
+  char *out = buf, phone[MAX_PHONE_LEN];
+  for (int i = first; i < first + n && i < view->count; i++)
+  {
+    int slot = view->slots[i];
+    out = appendInt(out, list->ids[slot]);
+    *out++ = '.';
+    *out++ = ' ';
+    out = appendText(out, nameOf(list, slot), MAX_NAME_LEN);
+    memcpy(out, " | ", 3);
+    out += 3;
+    out = appendText(out, phoneOf(list, slot, phone), MAX_PHONE_LEN);
+    *out++ = '\n';
+  }
+  return (size_t)(out - buf);
+}
+
+void searchContact(ContactList *list)
+{
+  ensureIndexes(list);
+  char key[MAX_NAME_LEN];
+  printf("Search Name : ");
+  fgets(key, MAX_NAME_LEN, stdin);
+  key[strcspn(key, "\n")] = '\0';
+
+  int i = indexFind(list, key);
+  if (i != -1)
+  {
+    Contact c = contactAt(list, i);
+    printf("Found: %s - %s\n", c.name, c.phone);
+    return;
+  }
+  printf("Contact not found.\n");
+}
+
+void updateContact(ContactList *list)
+{
+  ensureIndexes(list);
+  char key[MAX_NAME_LEN];
+  printf("Enter Name : ");
+  fgets(key, MAX_NAME_LEN, stdin);
+  key[strcspn(key, "\n")] = '\0';
+  int index = indexFind(list, key);
+
+  if (index == -1)
+    return;
+
+  char name[MAX_NAME_LEN];
+  char phoneNumber[MAX_PHONE_LEN];
+  int i, flag = 0;
+  Contact c = contactAt(list, index);
+
+  printf("\nEnter New Name (if you want to change it otherwise skip)         :: ");
+  fgets(name, MAX_NAME_LEN, stdin);
+  if (!((i = strcspn(name, "\n")) < 1))
+  {
+    name[i] = 0;
+    strcpy(c.name, name);
+    flag = 1;
+  }
+  printf("Enter New Phone Number (if you want to change it otherwise skip) ::");
+  fgets(phoneNumber, MAX_PHONE_LEN, stdin);
+  if (!((i = strcspn(phoneNumber, "\n")) < 1))
+  {
+    phoneNumber[i] = 0;
+    strcpy(c.phone, phoneNumber);
+    flag = 1;
+  }
+
+  if (flag)
+  {
+    replaceContact(list, index, &c);
+    printf("Changes are saved successfully\n");
+  }
+  else
+  {
+    printf("No changes made\n");
+  }
+}
+
+void deleteContact(ContactList *list)
+{
+  ensureIndexes(list);
+  int id;
+  printf("\nEnter contact number to delete: ");
+  scanf("%d", &id);
+  clearInputBuffer();
+
+  int slot = slotForId(list, id);
+  if (slot == -1)
+  {
+    printf("Invalid index\n");
+    return;
+  }
+
+  removeContact(list, slot);
+  printf("Contact deleted successfully\n");
+}
+
+void smartSearch(ContactList *list)
+{
+  static const char *kinds[] = {"exact", "prefix", "substring", "typo"};
+  ensureIndexes(list);
+  char key[MAX_NAME_LEN];
+  Match top[TOP_K];
+
+  printf("Search name or phone (prefix, part or typo) : ");
+  fgets(key, MAX_NAME_LEN, stdin);
+  key[strcspn(key, "\n")] = '\0';
+
+  int n = rankedSearch(list, key, top, TOP_K);
+  if (n == 0)
+  {
+    printf("No matching contacts.\n");
+    return;
+  }
+
+  printf("\n------ Best Matches ------\n");
+  for (int i = 0; i < n; i++)
+  {
+    Contact c = contactAt(list, top[i].pos);
+    printf("%d. %s | %s  (%s)\n",
+           list->ids[top[i].pos], c.name, c.phone, kinds[top[i].kind]);
+  }
+}
+
+void callerIdLookup(ContactList *list)
+{
+  ensureIndexes(list);
+  char phone[COMMAND_LEN];
+  printf("Enter Phone : ");
+  fgets(phone, sizeof(phone), stdin);
+  phone[strcspn(phone, "\n")] = '\0';
+
+  int i = phoneFind(list, phone);
+  if (i != -1)
+  {
+    Contact c = contactAt(list, i);
+    printf("Caller: %d. %s - %s\n", list->ids[i], c.name, c.phone);
+    return;
+  }
+  printf("Unknown caller.\n");
+}
+
+/* ===================== File Handling ===================== */
+
+uint64_t checksum64(uint64_t h, const void *buf, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)buf;
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+/* Checksum seed covering the header fields a damaged file could get wrong */
+static uint64_t snapshotSeed(const SnapshotHeader *h)
+{
+  uint64_t sum = 14695981039346656037ull;
+  if (h->version == 1)
+    return sum;
+  sum = checksum64(sum, &h->count, sizeof(h->count));
+  return checksum64(sum, &h->nextId, sizeof(h->nextId));
+}
+
+static uint32_t headerChecksum(const SnapshotHeader *h)
+{
+  uint64_t sum = checksum64(14695981039346656037ull, h, offsetof(SnapshotHeader, headerSum));
+  sum = checksum64(sum, &h->checksum, sizeof(h->checksum));
+  if (h->version >= 4)
+    sum = checksum64(sum, &h->arenaSize, sizeof(h->arenaSize));
+  return (uint32_t)sum;
+}
+
+/*
+ * Checks the columns of a freshly loaded snapshot against the header, and
+ * that every name and spilled number ends inside the arena. Until the list
+ * is indexed they are untouched, so the check can wait for the first
+ * caller that walks them all anyway.
+ */
+void verifySnapshot(const ContactList *list)
+{
+  if (list->indexed || !list->mapBase)
+    return;
+
+  const SnapshotHeader *h = (const SnapshotHeader *)list->mapBase;
+  const char *base = (const char *)list->mapBase;
+  bool ok = checksum64(snapshotSeed(h), base + sizeof(*h), list->mapLen - sizeof(*h)) ==
+            h->checksum;
+  for (int i = 0; ok && i < list->count; i++)
+  {
+    size_t nameEnd = (size_t)list->nameAt[i] + list->nameLen[i];
+    uint64_t packed = list->numbers[i];
+    size_t phoneEnd = (packed & PHONE_VALUE_MASK) + packedLen(packed);
+    ok = list->nameLen[i] < MAX_NAME_LEN && nameEnd < list->arenaUsed &&
+         list->arena[nameEnd] == '\0' && packedLen(packed) < MAX_PHONE_LEN &&
+         (!(packed & PHONE_SPILLED) ||
+          (phoneEnd < list->arenaUsed && list->arena[phoneEnd] == '\0'));
+  }
+  if (!ok)
+  {
+    printf("%s is corrupt, refusing to overwrite it\n", DATA_FILE);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/* Writes the entries of live slots from one column, size bytes each */
+static bool writeColumn(FILE *fp, const ContactList *list, const void *column,
+                        size_t size, uint64_t *sum)
+{
+  const char *p = (const char *)column;
+  if (list->tombstones == 0)
+  {
+    *sum = checksum64(*sum, p, size * list->count);
+    return fwrite(p, size, list->count, fp) == (size_t)list->count;
+  }
+  for (int i = 0; i < list->count; i++)
+  {
+    if (list->ids[i] == 0)
+      continue;
+    if (fwrite(p + size * i, size, 1, fp) != 1)
+      return false;
+    *sum = checksum64(*sum, p + size * i, size);
+  }
+  return true;
+}
+
+/*
+ * Writes a compacted snapshot next to the old file, then renames over it.
+ * Names are shared and dead arena bytes dropped on the way out. Returns
+ * false, leaving the old file alone, if any step fails.
+ */
+bool saveToFile(const ContactList *list)
+{
+  verifySnapshot(list);
+  size_t rows = list->count > 0 ? list->count : 1, arenaSize = 0;
+  uint32_t *nameAt = (uint32_t *)malloc(sizeof(uint32_t) * rows);
+  uint64_t *numbers = (uint64_t *)malloc(sizeof(uint64_t) * rows);
+  if (!nameAt || !numbers)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  char *arena = internNames(list, nameAt, numbers, &arenaSize);
+
+  FILE *fp = fopen(TEMP_FILE, "wb");
+  if (!fp)
+  {
+    free(nameAt);
+    free(numbers);
+    free(arena);
+    printf("Failed to save %s\n", DATA_FILE);
+    return false;
+  }
+
+  SnapshotHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, SNAPSHOT_MAGIC, 4);
+  h.version = SNAPSHOT_VERSION;
+  h.count = list->count - list->tombstones;
+  h.nextId = list->nextId;
+  h.recordSize = COLUMN_ROW_SIZE;
+  h.arenaSize = arenaSize;
+  h.checksum = snapshotSeed(&h);
+  bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+            writeColumn(fp, list, numbers, sizeof(uint64_t), &h.checksum) &&
+            writeColumn(fp, list, list->nameHash, sizeof(uint32_t), &h.checksum) &&
+            writeColumn(fp, list, nameAt, sizeof(uint32_t), &h.checksum) &&
+            writeColumn(fp, list, list->ids, sizeof(int), &h.checksum) &&
+            writeColumn(fp, list, list->nameLen, sizeof(uint8_t), &h.checksum) &&
+            fwrite(arena, 1, arenaSize, fp) == arenaSize;
+  h.checksum = checksum64(h.checksum, arena, arenaSize);
+  free(nameAt);
+  free(numbers);
+  free(arena);
+
+  h.headerSum = headerChecksum(&h);
+  rewind(fp);
+  ok = ok && fwrite(&h, sizeof(h), 1, fp) == 1 && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+  if (fclose(fp) != 0)
+    ok = false;
+  if (!ok || rename(TEMP_FILE, DATA_FILE) != 0)
+  {
+    remove(TEMP_FILE);
+    printf("Failed to save %s\n", DATA_FILE);
+    return false;
+  }
+  return true;
+}
+
+/* Converts count Contact records at base into slots [0, count) */
+static void storeRecords(ContactList *list, const char *base, int count)
+{
+  reserveList(list, count);
+  if (list->capacity < count)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < count; i++)
+  {
+    Contact c;
+    memcpy(&c, base + sizeof(Contact) * i, sizeof(c));
+    c.name[MAX_NAME_LEN - 1] = '\0';
+    c.phone[MAX_PHONE_LEN - 1] = '\0';
+    storeContact(list, i, &c);
+  }
+  list->count = count;
+}
+
+/* Pre-header files: an int count followed by that many Contact records */
+static void loadLegacy(ContactList *list, const char *base, size_t len)
+{
+  int count;
+  if (len < sizeof(int))
+    return;
+  memcpy(&count, base, sizeof(int));
+  if (count < 0 || (size_t)count > (len - sizeof(int)) / sizeof(Contact))
+  {
+    printf("%s is corrupt, refusing to overwrite it\n", DATA_FILE);
+    exit(EXIT_FAILURE);
+  }
+
+  storeRecords(list, base + sizeof(int), count);
+  for (int i = 0; i < count; i++)
+    list->ids[i] = i + 1;
+  list->nextId = count + 1;
+}
+
+/*
+ * Versions 1-3 held Contact records, then the ids. They are checked in full
+ * and converted here, as the rows have to be read anyway; the next save
+ * writes the current format. Returns false if the file fails validation.
+ */
+static bool loadRows(ContactList *list, const char *base, size_t len)
+{
+  const SnapshotHeader *h = (const SnapshotHeader *)base;
+  if (h->recordSize != sizeof(Contact) || h->count > (uint32_t)INT32_MAX / sizeof(Contact) ||
+      h->nextId <= h->count || (h->version == 3 && h->headerSum != headerChecksum(h)))
+    return false;
+
+  size_t records = ROW_HEADER_SIZE + (size_t)h->count * sizeof(Contact);
+  size_t idsAt = ALIGN_UP(records, sizeof(int));
+  if (len != idsAt + (size_t)h->count * sizeof(int))
+    return false;
+  uint64_t sum = checksum64(snapshotSeed(h), base + ROW_HEADER_SIZE, records - ROW_HEADER_SIZE);
+  sum = checksum64(sum, base + idsAt, (size_t)h->count * sizeof(int));
+  if (sum != h->checksum)
+    return false;
+
+  /* ids of deleted contacts stay retired even when none are left */
+  list->nextId = h->nextId;
+  storeRecords(list, base + ROW_HEADER_SIZE, (int)h->count);
+  memcpy(list->ids, base + idsAt, sizeof(int) * h->count);
+  return true;
+}
+
+/*
+ * Adopts a mapped snapshot in place; returns false if the header fails
+ * validation. The columns are checked later, by verifySnapshot().
+ */
+static bool adoptSnapshot(ContactList *list, char *base, size_t len)
+{
+  const SnapshotHeader *h = (const SnapshotHeader *)base;
+  if (len < sizeof(*h) || h->headerSum != headerChecksum(h) ||
+      h->recordSize != COLUMN_ROW_SIZE || h->count > (uint32_t)INT32_MAX ||
+      h->nextId <= h->count || h->arenaSize > UINT32_MAX)
+    return false;
+
+  size_t count = h->count;
+  if (len - sizeof(*h) != count * COLUMN_ROW_SIZE + h->arenaSize)
+    return false;
+
+  list->nextId = h->nextId;
+  if (count == 0)
+    return h->checksum == checksum64(snapshotSeed(h), base + sizeof(*h), len - sizeof(*h));
+
+  int *freeSlots = (int *)realloc(list->freeSlots, sizeof(int) * count);
+  if (!freeSlots)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  free(list->numbers);
+  free(list->nameHash);
+  free(list->nameAt);
+  free(list->nameLen);
+  free(list->ids);
+  free(list->arena);
+  list->freeSlots = freeSlots;
+
+  char *at = base + sizeof(*h);
+  list->numbers = (uint64_t *)at;
+  at += sizeof(uint64_t) * count;
+  list->nameHash = (uint32_t *)at;
+  at += sizeof(uint32_t) * count;
+  list->nameAt = (uint32_t *)at;
+  at += sizeof(uint32_t) * count;
+  list->ids = (int *)at;
+  at += sizeof(int) * count;
+  list->nameLen = (uint8_t *)at;
+  at += sizeof(uint8_t) * count;
+  list->arena = at;
+  list->arenaUsed = list->arenaCapacity = h->arenaSize;
+  list->arenaDead = 0;
+  list->count = list->capacity = (int)count;
+  list->mapBase = base;
+  list->mapLen = len;
+  return true;
+}
+
+void loadFromFile(ContactList *list)
+{
+  int fd = open(DATA_FILE, O_RDONLY);
+  if (fd == -1)
+    return;
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size == 0)
+  {
+    close(fd);
+    return;
+  }
+
+  size_t len = (size_t)st.st_size;
+  char *base = (char *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    printf("Failed to map %s\n", DATA_FILE);
+    exit(EXIT_FAILURE);
+  }
+
+  /* names are shared once indexed; until then each is stored as found */
+  list->indexed = false;
+  if (len >= ROW_HEADER_SIZE && memcmp(base, SNAPSHOT_MAGIC, 4) == 0)
+  {
+    const SnapshotHeader *h = (const SnapshotHeader *)base;
+    bool ok = h->version >= 1 && h->version <= SNAPSHOT_VERSION &&
+              (h->version < 4 ? loadRows(list, base, len) : adoptSnapshot(list, base, len));
+    if (!ok)
+    {
+      printf("%s is corrupt or from a newer version, refusing to overwrite it\n",
+             DATA_FILE);
+      exit(EXIT_FAILURE);
+    }
+  }
+  else
+  {
+    loadLegacy(list, base, len);
+  }
+
+  if (list->mapBase != base)
+    munmap(base, len);
+}
+
+/* ===================== Import / Export ===================== */
+
+typedef void (*LineHandler)(void *ctx, const char *line, int len);
+
+typedef struct
+{
+  ContactList *list;
+  Contact batch[IMPORT_BATCH];
+  unsigned char valid[IMPORT_BATCH];
+  int pending;
+  bool vcard;
+  bool inCard;
+  bool firstLine;
+  Contact card;
+  long imported, duplicates, invalid;
+} Importer;
+
+static double secondsSince(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static bool hasSuffix(const char *s, const char *suffix)
+{
+  size_t ls = strlen(s), lx = strlen(suffix);
+  return ls >= lx && strcasecmp(s + ls - lx, suffix) == 0;
+}
+
+/* Copies text[0, len) into a zero-padded field; false if it does not fit */
+static bool copyField(char *field, int size, const char *text, int len)
+{
+  while (len > 0 && isspace((unsigned char)*text))
+    text++, len--;
+  while (len > 0 && isspace((unsigned char)text[len - 1]))
+    len--;
+  memset(field, 0, size);
+  if (len >= size)
+    return false;
+  memcpy(field, text, len);
+  return true;
+}
+
+/*
+ * Canonicalizes and validates every phone in the batch with one SIMD pass,
+ * grows the list once, then inserts. "+91 9876543210" imports as digits.
+ */
+static void flushBatch(Importer *im)
+{
+  ContactList *list = im->list;
+  phoneCanonicalizeBatch(im->batch[0].phone, sizeof(Contact), MAX_PHONE_LEN,
+                         im->pending, im->valid);
+  ensureIndexes(list);
+  reserveList(list, list->count + im->pending);
+
+  for (int i = 0; i < im->pending; i++)
+  {
+    if (!im->valid[i] || im->batch[i].name[0] == '\0')
+      im->invalid++;
+    else if (indexFind(list, im->batch[i].name) != -1)
+      im->duplicates++;
+    else
+    {
+      insertContact(list, &im->batch[i]);
+      im->imported++;
+    }
+  }
+  im->pending = 0;
+}
+
+static void queueContact(Importer *im, const Contact *c)
+{
+  im->batch[im->pending++] = *c;
+  if (im->pending == IMPORT_BATCH)
+    flushBatch(im);
+}
+
+/* name,phone with an optional header row and optional quotes around name */
+static void importCsvLine(Importer *im, const char *line, int len)
+{
+  char name[MAX_NAME_LEN * 2];
+  int nlen = 0, i = 0;
+  Contact c;
+
+  if (len == 0)
+    return;
+  if (line[0] == '"')
+  {
+    for (i = 1; i < len; i++)
+    {
+      if (line[i] == '"' && i + 1 < len && line[i + 1] == '"')
+        i++;
+      else if (line[i] == '"')
+        break;
+      if (nlen < (int)sizeof(name))
+        name[nlen++] = line[i];
+    }
+    while (i < len && line[i] != ',')
+      i++;
+  }
+  else
+  {
+    for (; i < len && line[i] != ','; i++)
+      if (nlen < (int)sizeof(name))
+        name[nlen++] = line[i];
+  }
+
+  bool header = im->firstLine;
+  im->firstLine = false;
+  if (header && nlen == 4 && strncasecmp(name, "name", 4) == 0)
+    return;
+
+  /* a name or phone too long for its field rejects the row, never truncates */
+  if (i >= len || !copyField(c.phone, MAX_PHONE_LEN, line + i + 1, len - i - 1) ||
+      !copyField(c.name, MAX_NAME_LEN, name, nlen))
+  {
+    im->invalid++;
+    return;
+  }
+  queueContact(im, &c);
+}
+
+/* Picks FN and the first TEL out of each BEGIN:VCARD ... END:VCARD block */
+static void importVcardLine(Importer *im, const char *line, int len)
+{
+  const char *colon = memchr(line, ':', len);
+  int keyLen = colon ? (int)(colon - line) : len;
+  const char *value = colon ? colon + 1 : line + len;
+  int valueLen = (int)(line + len - value);
+
+  if (keyLen == 5 && strncasecmp(line, "BEGIN", 5) == 0)
+  {
+    memset(&im->card, 0, sizeof(im->card));
+    im->inCard = true;
+  }
+  else if (!im->inCard)
+    return;
+  else if (keyLen == 3 && strncasecmp(line, "END", 3) == 0)
+  {
+    im->inCard = false;
+    if (im->card.phone[0] == '\0')
+      im->invalid++;
+    else
+      queueContact(im, &im->card);
+  }
+  else if (keyLen >= 2 && strncasecmp(line, "FN", 2) == 0 &&
+           (keyLen == 2 || line[2] == ';'))
+    copyField(im->card.name, MAX_NAME_LEN, value, valueLen); /* too long leaves it empty */
+  else if (keyLen >= 3 && strncasecmp(line, "TEL", 3) == 0 &&
+           (keyLen == 3 || line[3] == ';') && im->card.phone[0] == '\0')
+  {
+    if (!copyField(im->card.phone, MAX_PHONE_LEN, value, valueLen))
+      im->card.phone[0] = '\0';
+  }
+}
+
+static void importLine(void *ctx, const char *line, int len)
+{
+  Importer *im = (Importer *)ctx;
+  if (len > 0 && line[len - 1] == '\r')
+    len--;
+  if (im->vcard)
+    importVcardLine(im, line, len);
+  else
+    importCsvLine(im, line, len);
+}
+
+/*
+ * Feeds every line of fp (without its newline) to fn, reading through buf
+ * in IO_BUFFER_SIZE chunks. Returns how many lines were dropped for not
+ * fitting in the buffer; the rest of such a line is skipped up to its
+ * newline rather than read as a line of its own.
+ */
+static long streamLines(FILE *fp, char *buf, LineHandler fn, void *ctx)
+{
+  size_t have = 0, got;
+  long dropped = 0;
+  bool eof = false, skipping = false;
+  while (!eof)
+  {
+    got = fread(buf + have, 1, IO_BUFFER_SIZE - have, fp);
+    have += got;
+    eof = got == 0;
+
+    size_t pos = 0;
+    char *nl;
+    while ((nl = memchr(buf + pos, '\n', have - pos)) != NULL)
+    {
+      if (skipping)
+        skipping = false;
+      else
+        fn(ctx, buf + pos, (int)(nl - (buf + pos)));
+      pos = nl - buf + 1;
+    }
+    if (eof && pos < have)
+    {
+      if (!skipping)
+        fn(ctx, buf + pos, (int)(have - pos));
+      pos = have;
+    }
+    else if (pos == 0 && have == IO_BUFFER_SIZE)
+    {
+      if (!skipping)
+        dropped++;
+      skipping = true;
+      pos = have;
+    }
+    memmove(buf, buf + pos, have - pos);
+    have -= pos;
+  }
+  return dropped;
+}
+
+/* Streams a CSV or vCard file through IO_BUFFER_SIZE reads */
+bool importContacts(ContactList *list, const char *path)
+{
+  FILE *fp = fopen(path, "rb");
+  char *buf = (char *)malloc(IO_BUFFER_SIZE);
+  Importer *im = (Importer *)calloc(1, sizeof(Importer));
+  if (!fp || !buf || !im)
+  {
+    printf("Cannot import %s\n", path);
+    if (fp)
+      fclose(fp);
+    free(buf);
+    free(im);
+    return false;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  im->list = list;
+  im->vcard = hasSuffix(path, ".vcf") || hasSuffix(path, ".vcard");
+  im->firstLine = true;
+
+  im->invalid += streamLines(fp, buf, importLine, im);
+  flushBatch(im);
+
+  double secs = secondsSince(&start);
+  long total = im->imported + im->duplicates + im->invalid;
+  printf("Imported %ld contact(s), skipped %ld duplicate(s) and %ld invalid row(s)\n",
+         im->imported, im->duplicates, im->invalid);
+  printf("%ld records in %.3f s (%.0f records/sec)\n",
+         total, secs, secs > 0 ? total / secs : 0.0);
+
+  bool ok = !ferror(fp);
+  fclose(fp);
+  free(buf);
+  free(im);
+  return ok;
+}
+
+/*
+ * Appends text to the output buffer, flushing it to fp when full. A failed
+ * write leaves the error flag on fp for the caller to check.
+ */
+static void emit(FILE *fp, char *buf, size_t *used, const char *text, size_t len)
+{
+  if (*used + len > IO_BUFFER_SIZE)
+  {
+    fwrite(buf, 1, *used, fp);
+    *used = 0;
+  }
+  memcpy(buf + *used, text, len);
+  *used += len;
+}
+
+bool exportContacts(const ContactList *list, const char *path)
+{
+  verifySnapshot(list);
+  FILE *fp = fopen(path, "wb");
+  char *buf = (char *)malloc(IO_BUFFER_SIZE);
+  if (!fp || !buf)
+  {
+    printf("Cannot export to %s\n", path);
+    if (fp)
+      fclose(fp);
+    free(buf);
+    return false;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  bool vcard = hasSuffix(path, ".vcf") || hasSuffix(path, ".vcard");
+  size_t used = 0;
+  long total = 0;
+  char row[3 * MAX_NAME_LEN + MAX_PHONE_LEN + 64];
+
+  if (!vcard)
+    emit(fp, buf, &used, "name,phone\n", 11);
+  for (int i = 0; i < list->count; i++)
+  {
+    if (list->ids[i] == 0)
+      continue;
+    Contact contact = contactAt(list, i);
+    const Contact *c = &contact;
+    int len = 0;
+    if (vcard)
+    {
+      len = snprintf(row, sizeof(row),
+                     "BEGIN:VCARD\nVERSION:3.0\nFN:%s\nTEL:%s\nEND:VCARD\n",
+                     c->name, c->phone);
+    }
+    else if (strpbrk(c->name, ",\"") != NULL)
+    {
+      row[len++] = '"';
+      for (const char *p = c->name; *p; p++)
+      {
+        if (*p == '"')
+          row[len++] = '"';
+        row[len++] = *p;
+      }
+      len += snprintf(row + len, sizeof(row) - len, "\",%s\n", c->phone);
+    }
+    else
+    {
+      len = snprintf(row, sizeof(row), "%s,%s\n", c->name, c->phone);
+    }
+    emit(fp, buf, &used, row, len);
+    total++;
+  }
+  fwrite(buf, 1, used, fp);
+
+  bool ok = !ferror(fp);
+  if (fclose(fp) != 0)
+    ok = false;
+  free(buf);
+  if (!ok)
+  {
+    printf("Failed to write %s\n", path);
+    return false;
+  }
+  double secs = secondsSince(&start);
+  printf("Exported %ld contact(s) in %.3f s (%.0f records/sec)\n",
+         total, secs, secs > 0 ? total / secs : 0.0);
+  return ok;
+}
+
+/* ===================== Batch Commands ===================== */
+
+/*
+ * One command per line, fields separated by '|':
+ *   add <name>|<phone>
+ *   find <name>
+ *   update <name>|<new name>|<new phone>   (leave a field empty to keep it)
+ *   del <id>
+ *   callerid <phone>                       (separators are ignored)
+ * Results go to stdout through one large buffer; the latency report at
+ * the end goes to stderr so it never mixes with the results.
+ */
+
+typedef enum
+{
+  CMD_ADD,
+  CMD_FIND,
+  CMD_UPDATE,
+  CMD_DEL,
+  CMD_CALLERID,
+  CMD_COUNT
+} CommandKind;
+
+typedef struct
+{
+  uint64_t *nanos;
+  long count;
+  long capacity;
+} LatencyLog;
+
+typedef struct
+{
+  ContactList *list;
+  char *out;
+  size_t used;
+  long errors;
+  LatencyLog latency[CMD_COUNT];
+} BatchRun;
+
+static const char *commandNames[CMD_COUNT] = {"add", "find", "update", "del",
+                                              "callerid"};
+
+static void batchReply(BatchRun *b, const char *fmt, ...)
+{
+  char line[COMMAND_LEN + 64];
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+  if (len >= (int)sizeof(line))
+    len = sizeof(line) - 1;
+  emit(stdout, b->out, &b->used, line, len);
+}
+
+/* Splits "a|b|c" in place into at most max trimmed fields */
+static int splitFields(char *text, char **fields, int max)
+{
+  int n = 0;
+  while (n < max)
+  {
+    char *bar = n < max - 1 ? strchr(text, '|') : NULL;
+    if (bar)
+      *bar = '\0';
+    while (isspace((unsigned char)*text))
+      text++;
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1]))
+      *--end = '\0';
+    fields[n++] = text;
+    if (!bar)
+      break;
+    text = bar + 1;
+  }
+  return n;
+}
+
+/* Fills a zero-padded Contact; false if a field is empty or too long */
+static bool makeContact(Contact *c, const char *name, const char *phone)
+{
+  memset(c, 0, sizeof(*c));
+  if (!*name || strlen(name) >= MAX_NAME_LEN || strlen(phone) >= MAX_PHONE_LEN)
+    return false;
+  strcpy(c->name, name);
+  strcpy(c->phone, phone);
+  return validatePhone(c->phone);
+}
+
+static void batchAdd(BatchRun *b, char *args)
+{
+  char *f[2];
+  Contact c;
+  if (splitFields(args, f, 2) != 2 || !makeContact(&c, f[0], f[1]))
+  {
+    b->errors++;
+    batchReply(b, "error bad contact\n");
+    return;
+  }
+  batchReply(b, "added %d\n", insertContact(b->list, &c));
+}
+
+static void batchFind(BatchRun *b, char *args)
+{
+  char *f[1];
+  splitFields(args, f, 1);
+  int slot = indexFind(b->list, f[0]);
+  Contact c;
+  if (slot == -1)
+  {
+    batchReply(b, "not found\n");
+    return;
+  }
+  c = contactAt(b->list, slot);
+  batchReply(b, "%d. %s | %s\n", b->list->ids[slot], c.name, c.phone);
+}
+
+static void batchUpdate(BatchRun *b, char *args)
+{
+  char *f[3];
+  if (splitFields(args, f, 3) != 3)
+  {
+    b->errors++;
+    batchReply(b, "error usage: update <name>|<new name>|<new phone>\n");
+    return;
+  }
+  int slot = indexFind(b->list, f[0]);
+  if (slot == -1)
+  {
+    batchReply(b, "not found\n");
+    return;
+  }
+
+  Contact old = contactAt(b->list, slot), c;
+  if (!makeContact(&c, *f[1] ? f[1] : old.name, *f[2] ? f[2] : old.phone))
+  {
+    b->errors++;
+    batchReply(b, "error bad contact\n");
+    return;
+  }
+  replaceContact(b->list, slot, &c);
+  batchReply(b, "updated %d\n", b->list->ids[slot]);
+}
+
+static void batchDelete(BatchRun *b, char *args)
+{
+  char *end;
+  long id = strtol(args, &end, 10);
+  int slot = end != args && id > 0 && id <= INT32_MAX ? slotForId(b->list, (int)id) : -1;
+  if (slot == -1)
+  {
+    batchReply(b, "not found\n");
+    return;
+  }
+  removeContact(b->list, slot);
+  batchReply(b, "deleted %ld\n", id);
+}
+
+static void batchCallerId(BatchRun *b, char *args)
+{
+  char *f[1];
+  splitFields(args, f, 1);
+  int slot = phoneFind(b->list, f[0]);
+  Contact c;
+  if (slot == -1)
+  {
+    batchReply(b, "not found\n");
+    return;
+  }
+  c = contactAt(b->list, slot);
+  batchReply(b, "%d. %s | %s\n", b->list->ids[slot], c.name, c.phone);
+}
+
+static void recordLatency(LatencyLog *log, uint64_t nanos)
+{
+  if (log->count == log->capacity)
+  {
+    long capacity = log->capacity ? log->capacity * 2 : 1024;
+    uint64_t *temp = (uint64_t *)realloc(log->nanos, sizeof(uint64_t) * capacity);
+    if (!temp)
+      return;
+    log->nanos = temp;
+    log->capacity = capacity;
+  }
+  log->nanos[log->count++] = nanos;
+}
+
+static void batchLine(void *ctx, const char *line, int len)
+{
+  BatchRun *b = (BatchRun *)ctx;
+  char cmd[COMMAND_LEN];
+  struct timespec start, end;
+
+  while (len > 0 && isspace((unsigned char)line[len - 1]))
+    len--;
+  if (len == 0 || line[0] == '#')
+    return;
+  if (len >= COMMAND_LEN)
+  {
+    b->errors++;
+    batchReply(b, "error line too long\n");
+    return;
+  }
+  memcpy(cmd, line, len);
+  cmd[len] = '\0';
+
+  char *args = cmd + strcspn(cmd, " \t");
+  if (*args)
+    *args++ = '\0';
+
+  int kind = 0;
+  while (kind < CMD_COUNT && strcmp(cmd, commandNames[kind]) != 0)
+    kind++;
+  if (kind == CMD_COUNT)
+  {
+    b->errors++;
+    batchReply(b, "error unknown command '%s'\n", cmd);
+    return;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  switch (kind)
+  {
+  case CMD_ADD:
+    batchAdd(b, args);
+    break;
+  case CMD_FIND:
+    batchFind(b, args);
+    break;
+  case CMD_UPDATE:
+    batchUpdate(b, args);
+    break;
+  case CMD_DEL:
+    batchDelete(b, args);
+    break;
+  case CMD_CALLERID:
+    batchCallerId(b, args);
+    break;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  recordLatency(&b->latency[kind], (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000u +
+                                       (uint64_t)(end.tv_nsec - start.tv_nsec));
+}
+
+static int compareNanos(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static void reportLatency(const BatchRun *b, double secs)
+{
+  long total = 0;
+  fprintf(stderr, "%-8s %9s %10s %10s %10s %10s\n",
+          "command", "count", "p50 us", "p90 us", "p99 us", "max us");
+  for (int k = 0; k < CMD_COUNT; k++)
+  {
+    const LatencyLog *log = &b->latency[k];
+    if (log->count == 0)
+      continue;
+    qsort(log->nanos, log->count, sizeof(uint64_t), compareNanos);
+    fprintf(stderr, "%-8s %9ld %10.2f %10.2f %10.2f %10.2f\n", commandNames[k],
+            log->count, log->nanos[log->count * 50 / 100] / 1e3,
+            log->nanos[log->count * 90 / 100] / 1e3,
+            log->nanos[log->count * 99 / 100] / 1e3,
+            log->nanos[log->count - 1] / 1e3);
+    total += log->count;
+  }
+  fprintf(stderr, "%ld command(s), %ld error(s) in %.3f s (%.0f commands/sec)\n",
+          total, b->errors, secs, secs > 0 ? total / secs : 0.0);
+}
+
+/* Runs a command stream from path, or stdin when path is NULL */
+bool runBatch(ContactList *list, const char *path)
+{
+  FILE *fp = path ? fopen(path, "rb") : stdin;
+  char *in = (char *)malloc(IO_BUFFER_SIZE);
+  BatchRun b;
+  memset(&b, 0, sizeof(b));
+  b.list = list;
+  b.out = (char *)malloc(IO_BUFFER_SIZE);
+  if (!fp || !in || !b.out)
+  {
+    printf("Cannot run batch from %s\n", path ? path : "stdin");
+    if (fp && fp != stdin)
+      fclose(fp);
+    free(in);
+    free(b.out);
+    return false;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ensureIndexes(list);
+  b.errors += streamLines(fp, in, batchLine, &b);
+  fwrite(b.out, 1, b.used, stdout);
+  fflush(stdout);
+  reportLatency(&b, secondsSince(&start));
+
+  bool ok = !ferror(fp);
+  if (fp != stdin)
+    fclose(fp);
+  for (int k = 0; k < CMD_COUNT; k++)
+    free(b.latency[k].nanos);
+  free(in);
+  free(b.out);
+  return ok;
+}
+
+/* ===================== Server ===================== */
+
+/*
+ * serve answers the batch commands over a Unix socket, one thread per
+ * client, and replies one line per command in order. Contacts are split
+ * into SHARD_COUNT lists by the top bits of their name hash, each behind
+ * its own rwlock: finds on a shard run side by side, and a write only
+ * holds up the one shard it touches. Ids stay global; the directory maps
+ * each to its shard and the shard's own id. Locks are always taken shard
+ * (lower index first), then directory, then journal.
+ */
+
+typedef struct
+{
+  ContactList list;
+  int *globalOf; /* shard id -> global id */
+  int globalCapacity;
+  pthread_rwlock_t lock;
+} Shard;
+
+typedef struct
+{
+  Shard shards[SHARD_COUNT];
+  uint64_t *directory; /* global id -> (shard + 1) << 32 | shard id, 0 once deleted */
+  int dirCapacity;
+  int nextId;
+  pthread_rwlock_t dirLock;
+  ContactList *store; /* owns the journal; holds contacts only at start-up and exit */
+  pthread_mutex_t journalLock;
+  int snapshotLive; /* contacts in the last snapshot, sizes the checkpoint threshold */
+  bool checkpointing; /* a snapshot is being saved outside the locks */
+  pthread_mutex_t clientLock;
+  pthread_cond_t clientsGone;
+  int clients[SERVER_MAX_CLIENTS];
+  int clientCount;
+} Server;
+
+typedef struct
+{
+  Server *srv;
+  int fd;
+  bool dirty; /* journal records to commit before the replies go out */
+  unsigned long firstGroup; /* journal group holding the first of them */
+  size_t used;
+  char in[SERVER_BUFFER];
+  char out[SERVER_BUFFER];
+} Connection;
+
+static volatile sig_atomic_t serverStop = 0;
+
+static void onServerSignal(int sig)
+{
+  (void)sig;
+  serverStop = 1;
+}
+
+static int shardFor(const char *name)
+{
+  return (int)(hashName(name) >> (32 - SHARD_BITS));
+}
+
+static void growInts(int **array, int *capacity, int needed)
+{
+  if (needed < *capacity)
+    return;
+  int fresh = *capacity ? *capacity : INITIAL_CAPACITY;
+  while (fresh <= needed)
+    fresh *= 2;
+  int *temp = (int *)realloc(*array, sizeof(int) * fresh);
+  if (!temp)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  *array = temp;
+  *capacity = fresh;
+}
+
+static void bindGlobal(Shard *sh, int local, int id)
+{
+  growInts(&sh->globalOf, &sh->globalCapacity, local);
+  sh->globalOf[local] = id;
+}
+
+/* Records where global id now lives; id 0 asks for a fresh one */
+static int directorySet(Server *srv, int id, int shard, int local)
+{
+  pthread_rwlock_wrlock(&srv->dirLock);
+  if (id == 0)
+    id = srv->nextId++;
+  if (id >= srv->dirCapacity)
+  {
+    int capacity = srv->dirCapacity ? srv->dirCapacity : INITIAL_CAPACITY;
+    while (capacity <= id)
+      capacity *= 2;
+    uint64_t *temp = (uint64_t *)realloc(srv->directory, sizeof(uint64_t) * capacity);
+    if (!temp)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    memset(temp + srv->dirCapacity, 0, sizeof(uint64_t) * (capacity - srv->dirCapacity));
+    srv->directory = temp;
+    srv->dirCapacity = capacity;
+  }
+  srv->directory[id] = shard < 0 ? 0 : (uint64_t)(shard + 1) << 32 | (uint32_t)local;
+  pthread_rwlock_unlock(&srv->dirLock);
+  return id;
+}
+
+/* Shard holding global id, or -1; *local gets the shard's id for it */
+static int directoryGet(Server *srv, int id, int *local)
+{
+  uint64_t entry = 0;
+  pthread_rwlock_rdlock(&srv->dirLock);
+  if (id > 0 && id < srv->dirCapacity)
+    entry = srv->directory[id];
+  pthread_rwlock_unlock(&srv->dirLock);
+  *local = (int)(uint32_t)entry;
+  return (int)(entry >> 32) - 1;
+}
+
+static void serverLog(Connection *cn, JournalOp op, int id, const Contact *c)
+{
+  Server *srv = cn->srv;
+  pthread_mutex_lock(&srv->journalLock);
+  if (!cn->dirty)
+    cn->firstGroup = srv->store->journal.groups + 1;
+  journalLog(srv->store, op, id, c);
+  pthread_mutex_unlock(&srv->journalLock);
+  cn->dirty = true;
+}
+
+/* Gathers the shards back into list for a snapshot */
+static void joinShards(Server *srv, ContactList *list)
+{
+  int total = 0;
+  for (int s = 0; s < SHARD_COUNT; s++)
+    total += srv->shards[s].list.count;
+  reserveList(list, total);
+  for (int s = 0; s < SHARD_COUNT; s++)
+  {
+    const ContactList *part = &srv->shards[s].list;
+    for (int i = 0; i < part->count; i++)
+    {
+      if (part->ids[i] == 0)
+        continue;
+      Contact c = contactAt(part, i);
+      int slot = allocSlot(list);
+      storeContact(list, slot, &c);
+      setId(list, slot, srv->shards[s].globalOf[part->ids[i]]);
+    }
+  }
+  /* ids past the last survivor stay used; saveToFile only needs nextId */
+  if (list->nextId < srv->nextId)
+    list->nextId = srv->nextId;
+}
+
+/*
+ * Folds the journal into a fresh snapshot while serving. Shard read locks
+ * keep writers out only while the contacts are copied and the journal is
+ * set aside; the snapshot is saved after that while writes go on into a
+ * fresh journal. The old one is dropped once the snapshot is in place, or
+ * put back in front of the new one if saving failed.
+ */
+static void serverCheckpoint(Server *srv)
+{
+  ContactList snap;
+  initList(&snap);
+  for (int s = 0; s < SHARD_COUNT; s++)
+    pthread_rwlock_rdlock(&srv->shards[s].lock);
+  pthread_rwlock_rdlock(&srv->dirLock);
+  pthread_mutex_lock(&srv->journalLock);
+
+  Journal *j = &srv->store->journal;
+  bool due = !srv->checkpointing && j->records >= JOURNAL_CHECKPOINT_MIN &&
+             j->records * 2 > srv->snapshotLive;
+  if (due)
+  {
+    journalCommit(srv->store);
+    due = journalSetAside(srv->store);
+  }
+  if (due)
+  {
+    joinShards(srv, &snap);
+    srv->checkpointing = true;
+  }
+  pthread_mutex_unlock(&srv->journalLock);
+  pthread_rwlock_unlock(&srv->dirLock);
+  for (int s = SHARD_COUNT - 1; s >= 0; s--)
+    pthread_rwlock_unlock(&srv->shards[s].lock);
+
+  if (due)
+  {
+    bool saved = saveToFile(&snap);
+    pthread_mutex_lock(&srv->journalLock);
+    if (saved && remove(JOURNAL_OLD_FILE) == 0)
+      srv->snapshotLive = snap.count;
+    else if (!journalRejoin(srv->store))
+      printf("Keeping %s until a snapshot succeeds\n", JOURNAL_OLD_FILE);
+    srv->checkpointing = false;
+    pthread_mutex_unlock(&srv->journalLock);
+  }
+  freeList(&snap);
+}
+
+static bool connSend(int fd, const char *text, size_t len)
+{
+  for (size_t sent = 0; sent < len;)
+  {
+    ssize_t n = send(fd, text + sent, len - sent, MSG_NOSIGNAL);
+    if (n <= 0)
+      return false;
+    sent += n;
+  }
+  return true;
+}
+
+/* Sends the buffered replies with every write acknowledgement turned into an error */
+static bool connSendUnsaved(Connection *cn)
+{
+  static const char unsaved[] = "error not saved\n";
+  for (size_t at = 0; at < cn->used;)
+  {
+    const char *line = cn->out + at;
+    const char *end = (const char *)memchr(line, '\n', cn->used - at);
+    size_t len = end ? (size_t)(end - line) + 1 : cn->used - at;
+    bool ack = strncmp(line, "added ", 6) == 0 || strncmp(line, "updated ", 8) == 0 ||
+               strncmp(line, "deleted ", 8) == 0;
+    if (!(ack ? connSend(cn->fd, unsaved, sizeof(unsaved) - 1) : connSend(cn->fd, line, len)))
+      return false;
+    at += len;
+  }
+  return true;
+}
+
+/* Sends the buffered replies, after the writes behind them are durable */
+static bool connFlush(Connection *cn)
+{
+  bool saved = true;
+  if (cn->dirty)
+  {
+    Server *srv = cn->srv;
+    pthread_mutex_lock(&srv->journalLock);
+    journalCommit(srv->store);
+    /* a group that failed may have held these writes, even if another thread wrote it */
+    saved = srv->store->journal.lastFailed < cn->firstGroup;
+    long records = srv->store->journal.records;
+    pthread_mutex_unlock(&srv->journalLock);
+    cn->dirty = false;
+    /* autoCheckpoint cannot see the shards, so the server folds its own journal */
+    if (records >= JOURNAL_CHECKPOINT_MIN && records * 2 > srv->snapshotLive)
+      serverCheckpoint(srv);
+  }
+  bool sent = saved ? connSend(cn->fd, cn->out, cn->used) : connSendUnsaved(cn);
+  cn->used = 0;
+  return sent;
+}
+
+static void connReply(Connection *cn, const char *fmt, ...)
+{
+  char line[COMMAND_LEN + 64];
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+  if (len >= (int)sizeof(line))
+    len = sizeof(line) - 1;
+  if (cn->used + len > SERVER_BUFFER)
+    connFlush(cn);
+  memcpy(cn->out + cn->used, line, len);
+  cn->used += len;
+}
+
+static void serverAdd(Connection *cn, char *args)
+{
+  char *f[2];
+  Contact c;
+  if (splitFields(args, f, 2) != 2 || !makeContact(&c, f[0], f[1]))
+  {
+    connReply(cn, "error bad contact\n");
+    return;
+  }
+
+  int s = shardFor(c.name);
+  Shard *sh = &cn->srv->shards[s];
+  pthread_rwlock_wrlock(&sh->lock);
+  int local = insertContact(&sh->list, &c);
+  int id = directorySet(cn->srv, 0, s, local);
+  bindGlobal(sh, local, id);
+  serverLog(cn, JOURNAL_ADD, id, &c);
+  pthread_rwlock_unlock(&sh->lock);
+  connReply(cn, "added %d\n", id);
+}
+
+static void serverFind(Connection *cn, char *args)
+{
+  char *f[1];
+  splitFields(args, f, 1);
+  Shard *sh = &cn->srv->shards[shardFor(f[0])];
+  Contact c;
+  int id = 0;
+
+  pthread_rwlock_rdlock(&sh->lock);
+  int slot = indexFind(&sh->list, f[0]);
+  if (slot != -1)
+  {
+    c = contactAt(&sh->list, slot);
+    id = sh->globalOf[sh->list.ids[slot]];
+  }
+  pthread_rwlock_unlock(&sh->lock);
+
+  if (slot == -1)
+    connReply(cn, "not found\n");
+  else
+    connReply(cn, "%d. %s | %s\n", id, c.name, c.phone);
+}
+
+/* A rename can move the contact to another shard; both are locked in order */
+static void serverUpdate(Connection *cn, char *args)
+{
+  char *f[3];
+  if (splitFields(args, f, 3) != 3)
+  {
+    connReply(cn, "error usage: update <name>|<new name>|<new phone>\n");
+    return;
+  }
+
+  Server *srv = cn->srv;
+  int s = shardFor(f[0]);
+  int t = *f[1] ? shardFor(f[1]) : s;
+  Shard *from = &srv->shards[s], *to = &srv->shards[t];
+  pthread_rwlock_wrlock(&srv->shards[s < t ? s : t].lock);
+  if (s != t)
+    pthread_rwlock_wrlock(&srv->shards[s < t ? t : s].lock);
+
+  int slot = indexFind(&from->list, f[0]);
+  Contact old, c;
+  int id = 0;
+  if (slot != -1)
+    old = contactAt(&from->list, slot);
+  bool ok = slot != -1 && makeContact(&c, *f[1] ? f[1] : old.name, *f[2] ? f[2] : old.phone);
+  if (ok)
+  {
+    id = from->globalOf[from->list.ids[slot]];
+    if (s == t)
+    {
+      replaceContact(&from->list, slot, &c);
+    }
+    else
+    {
+      removeContact(&from->list, slot);
+      int local = insertContact(&to->list, &c);
+      bindGlobal(to, local, id);
+      directorySet(srv, id, t, local);
+    }
+    serverLog(cn, JOURNAL_UPDATE, id, &c);
+  }
+
+  if (s != t)
+    pthread_rwlock_unlock(&srv->shards[s < t ? t : s].lock);
+  pthread_rwlock_unlock(&srv->shards[s < t ? s : t].lock);
+
+  if (slot == -1)
+    connReply(cn, "not found\n");
+  else if (!ok)
+    connReply(cn, "error bad contact\n");
+  else
+    connReply(cn, "updated %d\n", id);
+}
+
+static void serverDelete(Connection *cn, char *args)
+{
+  char *end;
+  long id = strtol(args, &end, 10);
+  if (end == args || id <= 0 || id > INT32_MAX)
+  {
+    connReply(cn, "not found\n");
+    return;
+  }
+
+  /* a concurrent rename may move the contact between lookup and lock */
+  int local, s;
+  while ((s = directoryGet(cn->srv, (int)id, &local)) != -1)
+  {
+    Shard *sh = &cn->srv->shards[s];
+    pthread_rwlock_wrlock(&sh->lock);
+    int slot = slotForId(&sh->list, local);
+    if (slot != -1 && sh->globalOf[local] == id)
+    {
+      removeContact(&sh->list, slot);
+      directorySet(cn->srv, (int)id, -1, 0);
+      serverLog(cn, JOURNAL_DELETE, (int)id, NULL);
+      pthread_rwlock_unlock(&sh->lock);
+      connReply(cn, "deleted %ld\n", id);
+      return;
+    }
+    pthread_rwlock_unlock(&sh->lock);
+  }
+  connReply(cn, "not found\n");
+}
+
+/* Numbers are not sharded, so every shard is asked and the oldest id wins */
+static void serverCallerId(Connection *cn, char *args)
+{
+  char *f[1];
+  splitFields(args, f, 1);
+  Contact c;
+  int id = 0;
+
+  for (int s = 0; s < SHARD_COUNT; s++)
+  {
+    Shard *sh = &cn->srv->shards[s];
+    pthread_rwlock_rdlock(&sh->lock);
+    int slot = phoneFind(&sh->list, f[0]);
+    if (slot != -1 && (id == 0 || sh->globalOf[sh->list.ids[slot]] < id))
+    {
+      c = contactAt(&sh->list, slot);
+      id = sh->globalOf[sh->list.ids[slot]];
+    }
+    pthread_rwlock_unlock(&sh->lock);
+  }
+
+  if (id == 0)
+    connReply(cn, "not found\n");
+  else
+    connReply(cn, "%d. %s | %s\n", id, c.name, c.phone);
+}
+
+static void serverLine(Connection *cn, const char *line, int len)
+{
+  char cmd[COMMAND_LEN];
+
+  while (len > 0 && isspace((unsigned char)line[len - 1]))
+    len--;
+  if (len == 0 || line[0] == '#')
+    return;
+  if (len >= COMMAND_LEN)
+  {
+    connReply(cn, "error line too long\n");
+    return;
+  }
+  memcpy(cmd, line, len);
+  cmd[len] = '\0';
+
+  char *args = cmd + strcspn(cmd, " \t");
+  if (*args)
+    *args++ = '\0';
+
+  if (strcmp(cmd, commandNames[CMD_ADD]) == 0)
+    serverAdd(cn, args);
+  else if (strcmp(cmd, commandNames[CMD_FIND]) == 0)
+    serverFind(cn, args);
+  else if (strcmp(cmd, commandNames[CMD_UPDATE]) == 0)
+    serverUpdate(cn, args);
+  else if (strcmp(cmd, commandNames[CMD_DEL]) == 0)
+    serverDelete(cn, args);
+  else if (strcmp(cmd, commandNames[CMD_CALLERID]) == 0)
+    serverCallerId(cn, args);
+  else
+    connReply(cn, "error unknown command '%s'\n", cmd);
+}
+
+static void dropClient(Server *srv, Connection *cn)
+{
+  pthread_mutex_lock(&srv->clientLock);
+  for (int i = 0; i < srv->clientCount; i++)
+    if (srv->clients[i] == cn->fd)
+      srv->clients[i] = srv->clients[--srv->clientCount];
+  if (srv->clientCount == 0)
+    pthread_cond_signal(&srv->clientsGone);
+  pthread_mutex_unlock(&srv->clientLock);
+  close(cn->fd);
+  free(cn);
+}
+
+static void *serveConnection(void *arg)
+{
+  Connection *cn = (Connection *)arg;
+  Server *srv = cn->srv;
+  size_t have = 0;
+  ssize_t n;
+
+  while ((n = read(cn->fd, cn->in + have, SERVER_BUFFER - have)) > 0)
+  {
+    have += n;
+    char *line = cn->in, *end = cn->in + have, *nl;
+    while ((nl = (char *)memchr(line, '\n', end - line)) != NULL)
+    {
+      serverLine(cn, line, (int)(nl - line));
+      line = nl + 1;
+    }
+    have = end - line;
+    memmove(cn->in, line, have);
+    if (have == SERVER_BUFFER)
+    {
+      connReply(cn, "error line too long\n");
+      have = 0;
+    }
+    /* everything this read brought in shares one commit and one send */
+    if (!connFlush(cn))
+      break;
+  }
+  connFlush(cn);
+
+  dropClient(srv, cn);
+  return NULL;
+}
+
+/* Deals the loaded contacts out to the shards under their existing ids */
+static void splitIntoShards(Server *srv, ContactList *list)
+{
+  ensureIndexes(list);
+  for (int i = 0; i < list->count; i++)
+  {
+    if (list->ids[i] == 0)
+      continue;
+    Contact c = contactAt(list, i);
+    int s = shardFor(c.name);
+    Shard *sh = &srv->shards[s];
+    int local = insertContact(&sh->list, &c);
+    bindGlobal(sh, local, list->ids[i]);
+    directorySet(srv, list->ids[i], s, local);
+  }
+  srv->nextId = list->nextId;
+}
+
+static int listenOn(const char *path)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path))
+    return -1;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1)
+    return -1;
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(fd, SERVER_MAX_CLIENTS) != 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/* Serves list on path until SIGINT or SIGTERM, then snapshots everything */
+bool runServer(ContactList *list, const char *path)
+{
+  int lfd = listenOn(path);
+  if (lfd == -1)
+  {
+    printf("Cannot listen on %s\n", path);
+    return false;
+  }
+
+  Server *srv = (Server *)calloc(1, sizeof(Server));
+  if (!srv)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int s = 0; s < SHARD_COUNT; s++)
+  {
+    initList(&srv->shards[s].list);
+    pthread_rwlock_init(&srv->shards[s].lock, NULL);
+  }
+  pthread_rwlock_init(&srv->dirLock, NULL);
+  pthread_mutex_init(&srv->journalLock, NULL);
+  srv->checkpointing = false;
+  pthread_mutex_init(&srv->clientLock, NULL);
+  pthread_cond_init(&srv->clientsGone, NULL);
+
+  splitIntoShards(srv, list);
+  int live = list->count - list->tombstones;
+  srv->snapshotLive = live;
+  /* the replayed records are still in the journal; a failed write trims back to them */
+  long replayed = list->journal.records;
+  freeList(list);
+  initList(list);
+  list->journal.records = replayed;
+  list->journal.autoCheckpoint = false;
+  journalOpen(list);
+  srv->store = list;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = onServerSignal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  printf("Serving %d contact(s) on %s across %d shards\n", live, path, SHARD_COUNT);
+  fflush(stdout);
+
+  while (!serverStop)
+  {
+    struct pollfd p = {lfd, POLLIN, 0};
+    if (poll(&p, 1, 200) <= 0)
+      continue;
+    int fd = accept(lfd, NULL, NULL);
+    if (fd == -1)
+      continue;
+
+    Connection *cn = (Connection *)malloc(sizeof(Connection));
+    pthread_mutex_lock(&srv->clientLock);
+    bool room = cn && srv->clientCount < SERVER_MAX_CLIENTS;
+    if (room)
+      srv->clients[srv->clientCount++] = fd;
+    pthread_mutex_unlock(&srv->clientLock);
+    if (!room)
+    {
+      free(cn);
+      close(fd);
+      continue;
+    }
+
+    pthread_t thread;
+    cn->srv = srv;
+    cn->fd = fd;
+    cn->dirty = false;
+    cn->used = 0;
+    if (pthread_create(&thread, NULL, serveConnection, cn) == 0)
+      pthread_detach(thread);
+    else
+      dropClient(srv, cn);
+  }
+  close(lfd);
+  unlink(path);
+
+  /* wake every client thread out of read() and wait for them to finish */
+  pthread_mutex_lock(&srv->clientLock);
+  for (int i = 0; i < srv->clientCount; i++)
+    shutdown(srv->clients[i], SHUT_RDWR);
+  while (srv->clientCount > 0)
+    pthread_cond_wait(&srv->clientsGone, &srv->clientLock);
+  pthread_mutex_unlock(&srv->clientLock);
+
+  joinShards(srv, list);
+  printf("Saving %d contact(s)\n", list->count);
+  bool saved = checkpoint(list);
+  saved = journalClose(list) && saved;
+
+  for (int s = 0; s < SHARD_COUNT; s++)
+  {
+    freeList(&srv->shards[s].list);
+    free(srv->shards[s].globalOf);
+    pthread_rwlock_destroy(&srv->shards[s].lock);
+  }
+  pthread_rwlock_destroy(&srv->dirLock);
+  pthread_mutex_destroy(&srv->journalLock);
+  pthread_mutex_destroy(&srv->clientLock);
+  pthread_cond_destroy(&srv->clientsGone);
+  free(srv->directory);
+  free(srv);
+  return saved;
+}
+
+/*
+ * loadgen opens clients connections and has each send requests commands,
+ * LOAD_PIPELINE at a time: one add in LOAD_WRITE_EVERY, the rest finds of
+ * names that client added earlier.
+ */
+
+typedef struct
+{
+  const char *path;
+  int client;
+  long requests;
+  long errors;
+  bool ok;
+} LoadClient;
+
+static int connectTo(const char *path)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr.sun_path))
+    return -1;
+  strcpy(addr.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd != -1 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+static void *loadClient(void *arg)
+{
+  LoadClient *lc = (LoadClient *)arg;
+  char out[LOAD_PIPELINE * COMMAND_LEN], in[SERVER_BUFFER];
+  uint32_t seed = 2463534242u + (uint32_t)lc->client * 7919u;
+  long added = 0;
+  bool lineStart = true;
+
+  int fd = connectTo(lc->path);
+  if (fd == -1)
+    return NULL;
+
+  for (long sent = 0; sent < lc->requests;)
+  {
+    int batch = lc->requests - sent < LOAD_PIPELINE ? (int)(lc->requests - sent)
+                                                    : LOAD_PIPELINE;
+    size_t used = 0;
+    for (int k = 0; k < batch; k++)
+    {
+      long i = sent + k;
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      if (i % LOAD_WRITE_EVERY == 0)
+        used += sprintf(out + used, "add load%d-%ld|%010ld\n", lc->client, added++, i);
+      else
+        used += sprintf(out + used, "find load%d-%ld\n", lc->client,
+                        added ? (long)(seed % (uint32_t)added) : 0);
+    }
+    for (size_t w = 0; w < used;)
+    {
+      ssize_t n = send(fd, out + w, used - w, MSG_NOSIGNAL);
+      if (n <= 0)
+      {
+        close(fd);
+        return NULL;
+      }
+      w += n;
+    }
+
+    /* one reply line per command; error replies are the ones starting with 'e' */
+    for (int replies = 0; replies < batch;)
+    {
+      ssize_t n = read(fd, in, sizeof(in));
+      if (n <= 0)
+      {
+        close(fd);
+        return NULL;
+      }
+      for (ssize_t k = 0; k < n; k++)
+      {
+        if (lineStart && in[k] == 'e')
+          lc->errors++;
+        lineStart = in[k] == '\n';
+        replies += lineStart;
+      }
+    }
+    sent += batch;
+  }
+  close(fd);
+  lc->ok = true;
+  return NULL;
+}
+
+bool runLoad(const char *path, int clients, long requests)
+{
+  if (clients < 1 || clients > SERVER_MAX_CLIENTS || requests < 1)
+  {
+    printf("loadgen needs 1..%d clients and at least one request each\n",
+           SERVER_MAX_CLIENTS);
+    return false;
+  }
+
+  LoadClient *lc = (LoadClient *)calloc(clients, sizeof(LoadClient));
+  pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * clients);
+  if (!lc || !threads)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  int started = 0;
+  for (; started < clients; started++)
+  {
+    lc[started].path = path;
+    lc[started].client = started;
+    lc[started].requests = requests;
+    if (pthread_create(&threads[started], NULL, loadClient, &lc[started]) != 0)
+      break;
+  }
+
+  long done = 0, errors = 0;
+  int failed = clients - started;
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+    if (lc[i].ok)
+      done += lc[i].requests;
+    else
+      failed++;
+    errors += lc[i].errors;
+  }
+  double secs = secondsSince(&start);
+
+  printf("%d client(s), %ld request(s), %ld error(s) in %.3f s (%.0f requests/sec)\n",
+         clients - failed, done, errors, secs, secs > 0 ? done / secs : 0.0);
+  if (failed)
+    printf("%d client(s) could not reach %s\n", failed, path);
+  free(lc);
+  free(threads);
+  return failed == 0;
+}
+
+/* ===================== Journal ===================== */
+
+static uint32_t journalChecksum(const JournalRecord *r)
+{
+  return (uint32_t)checksum64(14695981039346656037ull, r,
+                              offsetof(JournalRecord, checksum));
+}
+
+void journalOpen(ContactList *list)
+{
+  list->journal.fd = open(JOURNAL_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (list->journal.fd == -1)
+    printf("Failed to open %s, changes are kept until exit only\n", JOURNAL_FILE);
+}
+
+/* Re-applies the records of one journal file, dropping a torn tail; -1 if there is none */
+static long replayFile(ContactList *list, const char *path)
+{
+  FILE *fp = fopen(path, "rb");
+  if (!fp)
+    return -1;
+
+  JournalRecord r;
+  long good = 0;
+  while (fread(&r, sizeof(r), 1, fp) == 1 && r.checksum == journalChecksum(&r))
+  {
+    ensureIndexes(list);
+    int slot = r.id > 0 ? slotForId(list, r.id) : -1;
+    if (r.op == JOURNAL_DELETE)
+    {
+      if (slot != -1)
+        removeContact(list, slot);
+    }
+    else if (r.op == JOURNAL_ADD || r.op == JOURNAL_UPDATE)
+    {
+      r.contact.name[MAX_NAME_LEN - 1] = '\0';
+      r.contact.phone[MAX_PHONE_LEN - 1] = '\0';
+      if (slot != -1)
+      {
+        replaceContact(list, slot, &r.contact);
+      }
+      else if (r.id > 0)
+      {
+        slot = allocSlot(list);
+        storeContact(list, slot, &r.contact);
+        setId(list, slot, r.id);
+        list->version++;
+        indexInsert(list, slot);
+        gramAdd(list, slot);
+      }
+    }
+    good++;
+  }
+  fclose(fp);
+
+  if (truncate(path, good * (long)sizeof(JournalRecord)) != 0)
+    printf("Failed to trim %s\n", path);
+  return good;
+}
+
+/*
+ * Re-applies journaled changes on top of the snapshot. A journal set aside
+ * by a server snapshot that never finished holds the older changes, so it
+ * goes first and is then merged back into one file.
+ */
+void journalReplay(ContactList *list)
+{
+  long old = replayFile(list, JOURNAL_OLD_FILE);
+  long good = replayFile(list, JOURNAL_FILE);
+  long total = (old > 0 ? old : 0) + (good > 0 ? good : 0);
+  list->journal.records = good > 0 ? good : 0;
+  if (old >= 0 && !journalRejoin(list))
+    printf("Keeping %s until a snapshot succeeds\n", JOURNAL_OLD_FILE);
+  if (total > 0)
+    printf("Recovered %ld change(s) from %s\n", total, JOURNAL_FILE);
+}
+
+/*
+ * Moves the journal to JOURNAL_OLD_FILE and carries on in an empty one, so
+ * a snapshot can be saved while changes keep coming. Returns false, with
+ * the journal left as it was, if that is not possible.
+ */
+bool journalSetAside(ContactList *list)
+{
+  Journal *j = &list->journal;
+  if (j->fd == -1 || (access(JOURNAL_OLD_FILE, F_OK) == 0 && !journalRejoin(list)))
+    return false;
+  if (rename(JOURNAL_FILE, JOURNAL_OLD_FILE) != 0)
+    return false;
+  int fd = open(JOURNAL_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (fd == -1)
+  {
+    if (rename(JOURNAL_OLD_FILE, JOURNAL_FILE) != 0)
+      printf("Failed to restore %s\n", JOURNAL_FILE);
+    return false;
+  }
+  close(j->fd);
+  j->fd = fd;
+  j->records = 0;
+  return true;
+}
+
+/*
+ * Appends the journal to JOURNAL_OLD_FILE and moves the result back, so
+ * the set-aside records come first again. On failure both files stay and
+ * the next replay reads them in that order.
+ */
+bool journalRejoin(ContactList *list)
+{
+  Journal *j = &list->journal;
+  int to = open(JOURNAL_OLD_FILE, O_WRONLY | O_APPEND);
+  if (to == -1)
+    return false;
+  int from = open(JOURNAL_FILE, O_RDONLY);
+  bool ok = from != -1 || errno == ENOENT;
+
+  char buf[64 * 1024];
+  ssize_t n = 0;
+  while (ok && from != -1 && (n = read(from, buf, sizeof(buf))) > 0)
+    ok = write(to, buf, n) == n;
+  struct stat st;
+  ok = ok && n == 0 && fsync(to) == 0 && fstat(to, &st) == 0;
+  if (from != -1)
+    close(from);
+  ok = close(to) == 0 && ok && rename(JOURNAL_OLD_FILE, JOURNAL_FILE) == 0;
+  if (!ok)
+    return false;
+
+  j->records = st.st_size / (off_t)sizeof(JournalRecord);
+  if (j->fd != -1)
+  {
+    /* the open descriptor still points at the file that was just replaced */
+    close(j->fd);
+    journalOpen(list);
+  }
+  return true;
+}
+
+void journalLog(ContactList *list, JournalOp op, int id, const Contact *c)
+{
+  Journal *j = &list->journal;
+  if (j->fd == -1)
+    return;
+
+  JournalRecord *r = &j->pending[j->pendingCount++];
+  memset(r, 0, sizeof(*r));
+  r->op = op;
+  r->id = id;
+  if (c)
+    r->contact = *c;
+  r->checksum = journalChecksum(r);
+
+  if (j->pendingCount == JOURNAL_GROUP_SIZE)
+    journalCommit(list);
+}
+
+/* Group commit: one write and one fsync for every pending record */
+bool journalCommit(ContactList *list)
+{
+  Journal *j = &list->journal;
+  if (j->fd == -1 || j->pendingCount == 0)
+    return true;
+
+  size_t len = sizeof(JournalRecord) * j->pendingCount;
+  j->pendingCount = 0;
+  j->groups++;
+  if (write(j->fd, j->pending, len) != (ssize_t)len || fsync(j->fd) != 0)
+  {
+    j->lastFailed = j->groups;
+    /* cut off a torn group so later appends still replay */
+    printf("Failed to write %s\n", JOURNAL_FILE);
+    if (ftruncate(j->fd, j->records * (off_t)sizeof(JournalRecord)) != 0)
+      printf("Failed to trim %s\n", JOURNAL_FILE);
+    return j->autoCheckpoint && checkpoint(list);
+  }
+  j->records += len / sizeof(JournalRecord);
+
+  /* fold the journal away once replaying it costs about half a full load */
+  if (j->autoCheckpoint && j->records >= JOURNAL_CHECKPOINT_MIN &&
+      j->records * 2 > list->count - list->tombstones)
+    checkpoint(list);
+  return true;
+}
+
+/*
+ * Writes a fresh snapshot, after which the journal can start over. The
+ * journal is only emptied once the snapshot is safely in place.
+ */
+bool checkpoint(ContactList *list)
+{
+  if (!saveToFile(list))
+  {
+    printf("Keeping %s until a snapshot succeeds\n", JOURNAL_FILE);
+    return false;
+  }
+  if (list->journal.fd != -1 ? ftruncate(list->journal.fd, 0) != 0
+                             : truncate(JOURNAL_FILE, 0) != 0 && errno != ENOENT)
+    printf("Failed to reset %s\n", JOURNAL_FILE);
+  if (remove(JOURNAL_OLD_FILE) != 0 && errno != ENOENT)
+    printf("Failed to remove %s\n", JOURNAL_OLD_FILE);
+  list->journal.records = 0;
+  return true;
+}
+
+/* Flushes the journal, or saves a snapshot when there is none; false on failure */
+bool journalClose(ContactList *list)
+{
+  bool ok = list->journal.fd == -1 ? saveToFile(list) : journalCommit(list);
+  if (list->journal.fd != -1 && close(list->journal.fd) != 0)
+    ok = false;
+  list->journal.fd = -1;
+  return ok;
+}
+
+/* ===================== Name Index ===================== */
+
+/* FNV-1a over the case-folded name, so lookups match strcasecmp */
+unsigned int hashName(const char *name)
+{
+  unsigned int h = 2166136261u;
+  for (; *name; name++)
+  {
+    h ^= (unsigned char)tolower((unsigned char)*name);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void indexInit(NameIndex *idx, int capacity)
+{
+  idx->capacity = capacity;
+  idx->used = 0;
+  idx->slots = (IndexSlot *)malloc(sizeof(IndexSlot) * capacity);
+  if (!idx->slots)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < capacity; i++)
+    idx->slots[i].index = INDEX_EMPTY;
+}
+
+/* Place an entry without any load checks; caller guarantees a free slot */
+static void indexPlace(NameIndex *idx, unsigned int hash, int pos)
+{
+  unsigned int mask = (unsigned int)idx->capacity - 1;
+  unsigned int s = hash & mask;
+  while (idx->slots[s].index >= 0)
+    s = (s + 1) & mask;
+  if (idx->slots[s].index == INDEX_EMPTY)
+    idx->used++;
+  idx->slots[s].hash = hash;
+  idx->slots[s].index = pos;
+}
+
+/* Spreads a phoneKey() over the table; the low bits alone are too regular */
+static unsigned int hashPhone(uint64_t key)
+{
+  return (unsigned int)((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+/* Grow (or just purge deleted slots) so the table stays at most half full */
+static void indexReserve(NameIndex *idx, int entries)
+{
+  if ((idx->used + 1) * 2 <= idx->capacity)
+    return;
+
+  int capacity = INDEX_INITIAL_SLOTS;
+  while (capacity < (entries + 1) * 2)
+    capacity *= 2;
+
+  NameIndex fresh;
+  indexInit(&fresh, capacity);
+  for (int i = 0; i < idx->capacity; i++)
+    if (idx->slots[i].index >= 0)
+      indexPlace(&fresh, idx->slots[i].hash, idx->slots[i].index);
+  free(idx->slots);
+  *idx = fresh;
+}
+
+/* Contacts without a usable number are simply left out of the phone table */
+void indexInsert(ContactList *list, int pos)
+{
+  indexReserve(&list->index, list->count + 1);
+  indexPlace(&list->index, list->nameHash[pos], pos);
+  uint64_t key = phoneKeyOf(list, pos);
+  if (key)
+  {
+    indexReserve(&list->phones, list->count + 1);
+    indexPlace(&list->phones, hashPhone(key), pos);
+  }
+}
+
+static void indexErase(NameIndex *idx, unsigned int hash, int pos)
+{
+  unsigned int mask = (unsigned int)idx->capacity - 1;
+  unsigned int s = hash & mask;
+
+  while (idx->slots[s].index != INDEX_EMPTY)
+  {
+    if (idx->slots[s].index == pos)
+    {
+      idx->slots[s].index = INDEX_DELETED;
+      return;
+    }
+    s = (s + 1) & mask;
+  }
+}
+
+/* Call before slot pos changes; both tables are found by its old contents */
+void indexRemove(ContactList *list, int pos)
+{
+  indexErase(&list->index, list->nameHash[pos], pos);
+  uint64_t key = phoneKeyOf(list, pos);
+  if (key)
+    indexErase(&list->phones, hashPhone(key), pos);
+}
+
+/* Returns the slot of the oldest contact whose name matches key, or -1 */
+int indexFind(const ContactList *list, const char *key)
+{
+  const NameIndex *idx = &list->index;
+  unsigned int hash = hashName(key);
+  unsigned int mask = (unsigned int)idx->capacity - 1;
+  unsigned int s = hash & mask;
+  int found = -1;
+
+  while (idx->slots[s].index != INDEX_EMPTY)
+  {
+    int pos = idx->slots[s].index;
+    if (pos >= 0 && idx->slots[s].hash == hash &&
+        (found == -1 || list->ids[pos] < list->ids[found]) &&
+        strcasecmp(nameOf(list, pos), key) == 0)
+      found = pos;
+    s = (s + 1) & mask;
+  }
+  return found;
+}
+
+/*
+ * Returns the slot of the oldest contact whose number matches phone once
+ * both are reduced to digits ("+91 98450-12345" finds "919845012345"), or -1.
+ */
+int phoneFind(const ContactList *list, const char *phone)
+{
+  uint64_t key = phoneKey(phone);
+  if (key == 0)
+    return -1;
+
+  const NameIndex *idx = &list->phones;
+  unsigned int hash = hashPhone(key);
+  unsigned int mask = (unsigned int)idx->capacity - 1;
+  unsigned int s = hash & mask;
+  int found = -1;
+
+  while (idx->slots[s].index != INDEX_EMPTY)
+  {
+    int pos = idx->slots[s].index;
+    if (pos >= 0 && idx->slots[s].hash == hash &&
+        (found == -1 || list->ids[pos] < list->ids[found]) &&
+        phoneKeyOf(list, pos) == key)
+      found = pos;
+    s = (s + 1) & mask;
+  }
+  return found;
+}
+
+/* Bulk reload: size both tables once for count entries, then insert them all */
+void indexRebuild(ContactList *list)
+{
+  int capacity = INDEX_INITIAL_SLOTS;
+  while (capacity < (list->count + 1) * 2)
+    capacity *= 2;
+
+  free(list->index.slots);
+  free(list->phones.slots);
+  indexInit(&list->index, capacity);
+  indexInit(&list->phones, capacity);
+  for (int i = 0; i < list->count; i++)
+  {
+    if (list->ids[i] == 0)
+      continue;
+    indexPlace(&list->index, list->nameHash[i], i);
+    uint64_t key = phoneKeyOf(list, i);
+    if (key)
+      indexPlace(&list->phones, hashPhone(key), i);
+  }
+}
+
+/* ===================== Trigram Search ===================== */
+
+/*
+ * Every field is indexed as "\1\1" + folded text + "\2", so the anchored
+ * grams answer prefix queries of any length and the bare grams answer
+ * substring queries of three characters or more. A single edit changes at
+ * most three grams, which bounds the candidates for typo matching.
+ */
+
+void gramInit(GramIndex *g, int capacity)
+{
+  g->capacity = capacity;
+  g->used = 0;
+  g->stale = 0;
+  g->slots = (Posting *)calloc(capacity, sizeof(Posting));
+  if (!g->slots)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void gramFree(GramIndex *g)
+{
+  for (int i = 0; i < g->capacity; i++)
+    free(g->slots[i].positions);
+  free(g->slots);
+}
+
+static unsigned int gramHash(unsigned int gram)
+{
+  gram ^= gram >> 15;
+  gram *= 0x2c1b3c6du;
+  gram ^= gram >> 12;
+  return gram;
+}
+
+static Posting *gramLookup(const GramIndex *g, unsigned int gram)
+{
+  unsigned int mask = (unsigned int)g->capacity - 1;
+  unsigned int s = gramHash(gram) & mask;
+  while (g->slots[s].gram != 0)
+  {
+    if (g->slots[s].gram == gram)
+      return &g->slots[s];
+    s = (s + 1) & mask;
+  }
+  return NULL;
+}
+
+static Posting *gramSlot(GramIndex *g, unsigned int gram)
+{
+  if ((g->used + 1) * 2 > g->capacity)
+  {
+    GramIndex bigger;
+    gramInit(&bigger, g->capacity * 2);
+    unsigned int mask = (unsigned int)bigger.capacity - 1;
+    for (int i = 0; i < g->capacity; i++)
+    {
+      if (g->slots[i].gram == 0)
+        continue;
+      unsigned int s = gramHash(g->slots[i].gram) & mask;
+      while (bigger.slots[s].gram != 0)
+        s = (s + 1) & mask;
+      bigger.slots[s] = g->slots[i];
+    }
+    bigger.used = g->used;
+    bigger.stale = g->stale;
+    free(g->slots);
+    *g = bigger;
+  }
+
+  unsigned int mask = (unsigned int)g->capacity - 1;
+  unsigned int s = gramHash(gram) & mask;
+  while (g->slots[s].gram != 0 && g->slots[s].gram != gram)
+    s = (s + 1) & mask;
+  if (g->slots[s].gram == 0)
+  {
+    g->slots[s].gram = gram;
+    g->used++;
+  }
+  return &g->slots[s];
+}
+
+/* Splits text into folded trigrams; returns how many were written to out */
+static int gramsOf(const char *text, unsigned int tag,
+                   bool anchorStart, bool anchorEnd, unsigned int *out)
+{
+  unsigned char buf[GRAM_MAX + 2];
+  int len = 0, n = 0;
+
+  if (anchorStart)
+  {
+    buf[len++] = 1;
+    buf[len++] = 1;
+  }
+  for (; *text && len < GRAM_MAX; text++)
+    buf[len++] = (unsigned char)tolower((unsigned char)*text);
+  if (anchorEnd)
+    buf[len++] = 2;
+
+  for (int i = 0; i + 2 < len; i++)
+    out[n++] = tag | (unsigned int)buf[i] << 16 |
+               (unsigned int)buf[i + 1] << 8 | buf[i + 2];
+  return n;
+}
+
+static void gramPost(GramIndex *g, unsigned int gram, int pos)
+{
+  Posting *p = gramSlot(g, gram);
+  if (p->count > 0 && p->positions[p->count - 1] == pos)
+    return;
+  if (p->count == p->capacity)
+  {
+    int capacity = p->capacity ? p->capacity * 2 : 4;
+    int *temp = (int *)realloc(p->positions, sizeof(int) * capacity);
+    if (!temp)
+    {
+      printf("Memory resize failed\n");
+      return;
+    }
+    p->positions = temp;
+    p->capacity = capacity;
+  }
+  p->positions[p->count++] = pos;
+}
+
+void gramAdd(ContactList *list, int pos)
+{
+  unsigned int grams[GRAM_MAX + 2];
+  char phone[MAX_PHONE_LEN];
+
+  int n = gramsOf(nameOf(list, pos), 0, true, true, grams);
+  for (int i = 0; i < n; i++)
+    gramPost(&list->grams, grams[i], pos);
+
+  n = gramsOf(phoneOf(list, pos, phone), GRAM_PHONE_TAG, true, true, grams);
+  for (int i = 0; i < n; i++)
+    gramPost(&list->grams, grams[i], pos);
+}
+
+void gramRebuild(ContactList *list)
+{
+  gramFree(&list->grams);
+  gramInit(&list->grams, GRAM_INITIAL_SLOTS);
+  for (int i = 0; i < list->count; i++)
+    if (list->ids[i] != 0)
+      gramAdd(list, i);
+}
+
+/* Shortest posting list among the grams, or NULL if any gram is absent */
+static const Posting *rarestPosting(const GramIndex *g,
+                                    const unsigned int *grams, int n)
+{
+  const Posting *best = NULL;
+  for (int i = 0; i < n; i++)
+  {
+    const Posting *p = gramLookup(g, grams[i]);
+    if (!p)
+      return NULL;
+    if (!best || p->count < best->count)
+      best = p;
+  }
+  return best;
+}
+
+static bool startsWithFolded(const char *text, const char *key)
+{
+  for (; *key; text++, key++)
+    if (tolower((unsigned char)*text) != tolower((unsigned char)*key))
+      return false;
+  return true;
+}
+
+static bool containsFolded(const char *text, const char *key)
+{
+  for (; *text; text++)
+    if (startsWithFolded(text, key))
+      return true;
+  return false;
+}
+
+/* True when a and b differ by at most one insert, delete or substitution */
+static bool withinOneEdit(const char *a, const char *b)
+{
+  int la = strlen(a), lb = strlen(b);
+  if (la < lb)
+  {
+    const char *t = a;
+    a = b;
+    b = t;
+    int tl = la;
+    la = lb;
+    lb = tl;
+  }
+  if (la - lb > 1)
+    return false;
+
+  int i = 0;
+  while (i < lb && tolower((unsigned char)a[i]) == tolower((unsigned char)b[i]))
+    i++;
+  if (i == lb)
+    return true;
+
+  /* substitution skips a[i] and b[i]; insertion skips only a[i] */
+  int skip = la == lb ? 1 : 0;
+  for (i++; i < la; i++)
+    if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i - 1 + skip]))
+      return false;
+  return true;
+}
+
+/* Keeps the best k matches ordered by kind, then shorter name, then id */
+static void offerMatch(const ContactList *list, Match *top, int *n, int k,
+                       int pos, MatchKind kind)
+{
+  for (int i = 0; i < *n; i++)
+  {
+    if (top[i].pos != pos)
+      continue;
+    if (top[i].kind <= kind)
+      return;
+    for (; i < *n - 1; i++)
+      top[i] = top[i + 1];
+    (*n)--;
+    break;
+  }
+
+  int len = list->nameLen[pos];
+  int at = *n;
+  while (at > 0)
+  {
+    const Match *m = &top[at - 1];
+    int mlen = list->nameLen[m->pos];
+    if (m->kind < kind ||
+        (m->kind == kind && (mlen < len || (mlen == len &&
+                                            list->ids[m->pos] < list->ids[pos]))))
+      break;
+    at--;
+  }
+  if (at >= k)
+    return;
+
+  int last = *n < k ? *n : k - 1;
+  for (int i = last; i > at; i--)
+    top[i] = top[i - 1];
+  top[at].pos = pos;
+  top[at].kind = kind;
+  if (*n < k)
+    (*n)++;
+}
+
+/*
+ * Postings may point at tombstones or at slots reused since indexing. A
+ * number is unpacked into buf (MAX_PHONE_LEN bytes).
+ */
+static const char *fieldOf(const ContactList *list, int pos, int field, char *buf)
+{
+  if (list->ids[pos] == 0)
+    return NULL;
+  return field ? phoneOf(list, pos, buf) : nameOf(list, pos);
+}
+
+static void searchField(const ContactList *list, const char *key, int field,
+                        Match *top, int *n, int k)
+{
+  unsigned int grams[GRAM_MAX + 2];
+  unsigned int tag = field ? GRAM_PHONE_TAG : 0;
+  char buf[MAX_PHONE_LEN];
+  int len = strlen(key);
+  const Posting *p;
+
+  /* prefix (and exact) */
+  p = rarestPosting(&list->grams, grams, gramsOf(key, tag, true, false, grams));
+  for (int i = 0; p && i < p->count; i++)
+  {
+    const char *text = fieldOf(list, p->positions[i], field, buf);
+    if (text && startsWithFolded(text, key))
+      offerMatch(list, top, n, k, p->positions[i],
+                 text[len] == '\0' ? MATCH_EXACT : MATCH_PREFIX);
+  }
+
+  /* Shorter keys would need a full scan for substring and typo matches */
+  if (len < 3)
+    return;
+
+  p = rarestPosting(&list->grams, grams, gramsOf(key, tag, false, false, grams));
+  for (int i = 0; p && i < p->count; i++)
+  {
+    const char *text = fieldOf(list, p->positions[i], field, buf);
+    if (text && containsFolded(text, key))
+      offerMatch(list, top, n, k, p->positions[i], MATCH_SUBSTRING);
+  }
+
+  /* typo: count shared anchored grams per candidate in a scratch table */
+  int m = gramsOf(key, tag, true, true, grams);
+  int total = 0;
+  const Posting *lists[GRAM_MAX + 2];
+  for (int i = 0; i < m; i++)
+  {
+    lists[i] = gramLookup(&list->grams, grams[i]);
+    total += lists[i] ? lists[i]->count : 0;
+  }
+  if (total == 0)
+    return;
+
+  int size = 16;
+  while (size < total * 2)
+    size *= 2;
+  int *seen = (int *)malloc(sizeof(int) * size * 2);
+  if (!seen)
+    return;
+  for (int i = 0; i < size; i++)
+    seen[2 * i] = -1;
+
+  for (int g = 0; g < m; g++)
+  {
+    for (int i = 0; lists[g] && i < lists[g]->count; i++)
+    {
+      int pos = lists[g]->positions[i];
+      unsigned int s = gramHash((unsigned int)pos + 1) & (unsigned int)(size - 1);
+      while (seen[2 * s] != -1 && seen[2 * s] != pos)
+        s = (s + 1) & (unsigned int)(size - 1);
+      if (seen[2 * s] == -1)
+      {
+        seen[2 * s] = pos;
+        seen[2 * s + 1] = 0;
+      }
+      if (++seen[2 * s + 1] == m - 3)
+      {
+        const char *text = fieldOf(list, pos, field, buf);
+        if (text && withinOneEdit(text, key))
+          offerMatch(list, top, n, k, pos, MATCH_FUZZY);
+      }
+    }
+  }
+  free(seen);
+}
+
+/* Ranked prefix/substring/typo search over names and phones; returns hits */
+int rankedSearch(const ContactList *list, const char *key, Match *top, int k)
+{
+  int n = 0;
+  if (*key == '\0')
+    return 0;
+  searchField(list, key, 0, top, &n, k);
+  searchField(list, key, 1, top, &n, k);
+  return n;
+}
+
+/* ===================== Duplicate Detection ===================== */
+
+/*
+ * Finds contacts that are probably the same person without comparing every
+ * pair. Contacts are blocked once by the last digits of their number and
+ * once by a name key (lower case letters and digits only); inside a block
+ * each contact is compared with the next DEDUP_WINDOW members in sorted
+ * order, which covers small blocks completely and keeps huge ones linear.
+ * Blocks are shared out between threads, and matching pairs are joined
+ * into clusters with union-find. A cluster is kept as its lowest id.
+ */
+
+typedef struct
+{
+  uint64_t key;   /* block */
+  uint64_t order; /* position inside the block */
+  int slot;
+} BlockEntry;
+
+typedef struct
+{
+  const char (*nameKeys)[MAX_NAME_LEN];
+  const uint64_t *phoneKeys;
+  const BlockEntry *entries;
+  int first; /* [first, last) starts and ends on block edges */
+  int last;
+  int *pairs; /* slot pairs, two ints each */
+  long pairCount;
+  long pairCapacity;
+  long comparisons;
+} DedupWork;
+
+static void nameKeyOf(const char *name, char *out)
+{
+  int n = 0;
+  for (; *name; name++)
+    if (isalnum((unsigned char)*name))
+      out[n++] = (char)tolower((unsigned char)*name);
+  out[n] = '\0';
+}
 
-void initList(ContactList *);
-void loadFromFile(ContactList *);
-void saveToFile(const ContactList *);
-void addContact(ContactList *);
-void displayContacts(const ContactList *);
-void searchContact(const ContactList *);
-void updateContact(ContactList *);
-void deleteContact(ContactList *);
-bool validatePhone(const char *);
-void resizeList(ContactList *);
-void clearInputBuffer(void);
-void showMenu(void);
+/* Equal, or one is the other with a country or trunk prefix in front */
+static bool phonesCompatible(uint64_t a, uint64_t b)
+{
+  if (a == b)
+    return true;
+  if (a == 0 || b == 0)
+    return false;
+  uint64_t mask = (1ull << PHONE_KEY_SHIFT) - 1;
+  int la = (int)(a >> PHONE_KEY_SHIFT), lb = (int)(b >> PHONE_KEY_SHIFT);
+  if (la > lb)
+  {
+    uint64_t t = a;
+    a = b;
+    b = t;
+    int tl = la;
+    la = lb;
+    lb = tl;
+  }
+  if (la < DEDUP_SUFFIX_DIGITS)
+    return false;
+  uint64_t scale = 1;
+  for (int i = 0; i < la; i++)
+    scale *= 10;
+  return (b & mask) % scale == (a & mask);
+}
 
-/* ===================== Main ===================== */
+/* Numbers block on their last digits so a prefixed copy lands in the same block */
+static uint64_t phoneBlock(uint64_t key)
+{
+  if ((int)(key >> PHONE_KEY_SHIFT) < DEDUP_SUFFIX_DIGITS)
+    return key;
+  uint64_t scale = 1;
+  for (int i = 0; i < DEDUP_SUFFIX_DIGITS; i++)
+    scale *= 10;
+  return 1 + ((key & ((1ull << PHONE_KEY_SHIFT) - 1)) % scale);
+}
 
-int main(void)
+static bool likelySame(const DedupWork *w, int a, int b)
 {
-  ContactList list;
-  int choice;
+  const char *na = w->nameKeys[a], *nb = w->nameKeys[b];
+  bool names = *na && *nb && (strcmp(na, nb) == 0 || withinOneEdit(na, nb));
+  return names && phonesCompatible(w->phoneKeys[a], w->phoneKeys[b]);
+}
 
-  initList(&list);
-  loadFromFile(&list);
+static int compareBlockEntries(const void *a, const void *b)
+{
+  const BlockEntry *x = (const BlockEntry *)a, *y = (const BlockEntry *)b;
+  if (x->key != y->key)
+    return x->key < y->key ? -1 : 1;
+  if (x->order != y->order)
+    return x->order < y->order ? -1 : 1;
+  return x->slot - y->slot;
+}
 
-  while (1)
+static void *dedupBlocks(void *arg)
+{
+  DedupWork *w = (DedupWork *)arg;
+  for (int i = w->first; i < w->last; i++)
   {
-    showMenu();
-    if (scanf("%d", &choice) != 1)
-    {
-      clearInputBuffer();
-      continue;
-    }
-    clearInputBuffer();
-
-    switch (choice)
+    for (int j = i + 1; j < w->last && j <= i + DEDUP_WINDOW &&
+                        w->entries[j].key == w->entries[i].key;
+         j++)
     {
-    case 1:
-      addContact(&list);
-      break;
-    case 2:
-      displayContacts(&list);
-      break;
-    case 3:
-      searchContact(&list);
-      break;
-    case 4:
-      updateContact(&list);
-      break;
-    case 5:
-      deleteContact(&list);
-      break;
-    case 6:
-      saveToFile(&list);
-      printf("Exiting... Data saved.\n");
-      free(list.data);
-      return 0;
-    default:
-      printf("Invalid option!\n");
+      int a = w->entries[i].slot, b = w->entries[j].slot;
+      w->comparisons++;
+      if (!likelySame(w, a, b))
+        continue;
+      if (w->pairCount == w->pairCapacity)
+      {
+        long capacity = w->pairCapacity ? w->pairCapacity * 2 : 1024;
+        int *temp = (int *)realloc(w->pairs, sizeof(int) * 2 * capacity);
+        if (!temp)
+        {
+          printf("Memory allocation failed\n");
+          exit(EXIT_FAILURE);
+        }
+        w->pairs = temp;
+        w->pairCapacity = capacity;
+      }
+      w->pairs[w->pairCount * 2] = a;
+      w->pairs[w->pairCount * 2 + 1] = b;
+      w->pairCount++;
     }
   }
+  return NULL;
 }
 
-/* ===================== Core Functions ===================== */
-
-void initList(ContactList *list)
+/* Sorts one blocking of n entries and compares within its blocks on threads */
+static void runBlocking(DedupWork *proto, BlockEntry *entries, int n,
+                        DedupWork *work, int threads)
 {
-  list->count = 0;
-  list->capacity = INITIAL_CAPACITY;
-  list->data = (Contact *)malloc(sizeof(Contact) * list->capacity);
-  if (!list->data)
+  qsort(entries, n, sizeof(BlockEntry), compareBlockEntries);
+
+  pthread_t tid[DEDUP_MAX_THREADS];
+  bool joined[DEDUP_MAX_THREADS];
+  int at = 0;
+  for (int t = 0; t < threads; t++)
   {
-    printf("Memory allocation failed\n");
-    exit(EXIT_FAILURE);
+    int end = (int)((long)n * (t + 1) / threads);
+    while (end < n && end > 0 && entries[end].key == entries[end - 1].key)
+      end++;
+    if (end < at)
+      end = at;
+    work[t] = *proto;
+    work[t].entries = entries;
+    work[t].first = at;
+    work[t].last = end;
+    joined[t] = pthread_create(&tid[t], NULL, dedupBlocks, &work[t]) == 0;
+    if (!joined[t])
+      dedupBlocks(&work[t]);
+    at = end;
   }
+  for (int t = 0; t < threads; t++)
+    if (joined[t])
+      pthread_join(tid[t], NULL);
 }
 
-void resizeList(ContactList *list)
+/* First 8 key bytes, big-endian, so sorting by it is roughly alphabetical */
+static uint64_t keyPrefix(const char *key)
 {
-  list->capacity *= 2;
-  Contact *temp = (Contact *)realloc(list->data, sizeof(Contact) * list->capacity);
-  if (!temp)
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++)
   {
-    printf("Memory resize failed\n");
-    return;
+    v = v << 8 | (unsigned char)*key;
+    if (*key)
+      key++;
   }
-  list->data = temp;
+  return v;
 }
 
-void addContact(ContactList *list)
+static int findRoot(int *parent, int x)
 {
-  if (list->count == list->capacity)
-    resizeList(list);
-
-  Contact *c = &list->data[list->count];
-
-  printf("Enter Name : ");
-  fgets(c->name, MAX_NAME_LEN, stdin);
-  c->name[strcspn(c->name, "\n")] = '\0';
-
-  do
+  while (parent[x] != x)
   {
-    printf("Enter Phone : ");
-    fgets(c->phone, MAX_PHONE_LEN, stdin);
-    c->phone[strcspn(c->phone, "\n")] = '\0';
-  } while (!validatePhone(c->phone));
-
-  list->count++;
-  printf("Contact added successfully!\n");
+    parent[x] = parent[parent[x]];
+    x = parent[x];
+  }
+  return x;
 }
 
-void displayContacts(const ContactList *list)
+/* Reports duplicate clusters; with merge, deletes all but each lowest id */
+void dedupContacts(ContactList *list, bool merge)
 {
-  if (list->count == 0)
+  verifySnapshot(list);
+  struct timespec start, phase;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int n = list->count;
+  char(*nameKeys)[MAX_NAME_LEN] = (char(*)[MAX_NAME_LEN])malloc((size_t)(n ? n : 1) * MAX_NAME_LEN);
+  uint64_t *phoneKeys = (uint64_t *)malloc(sizeof(uint64_t) * (n ? n : 1));
+  BlockEntry *entries = (BlockEntry *)malloc(sizeof(BlockEntry) * (n ? n : 1));
+  int *parent = (int *)malloc(sizeof(int) * (n ? n : 1));
+  int *doomed = (int *)malloc(sizeof(int) * (n ? n : 1));
+  unsigned char *clustered = (unsigned char *)calloc(n ? n : 1, 1);
+  if (!nameKeys || !phoneKeys || !entries || !parent || !doomed || !clustered)
   {
-    printf("No contacts available.\n");
-    return;
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
   }
 
-  printf("\n------ Contact List ------\n");
-  for (int i = 0; i < list->count; i++)
+  for (int i = 0; i < n; i++)
   {
-    printf("%d. %s | %s\n",
-           i + 1, list->data[i].name, list->data[i].phone);
+    parent[i] = i;
+    nameKeys[i][0] = '\0';
+    phoneKeys[i] = 0;
+    if (list->ids[i] == 0)
+      continue;
+    nameKeyOf(nameOf(list, i), nameKeys[i]);
+    phoneKeys[i] = phoneKeyOf(list, i);
   }
-}
 
-void searchContact(const ContactList *list)
-{
-  char key[MAX_NAME_LEN];
-  printf("Search Name : ");
-  fgets(key, MAX_NAME_LEN, stdin);
-  key[strcspn(key, "\n")] = '\0';
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int threads = cpus < 1 ? 1 : cpus > DEDUP_MAX_THREADS ? DEDUP_MAX_THREADS : (int)cpus;
+  DedupWork proto, work[2][DEDUP_MAX_THREADS];
+  memset(&proto, 0, sizeof(proto));
+  proto.nameKeys = (const char(*)[MAX_NAME_LEN])nameKeys;
+  proto.phoneKeys = phoneKeys;
 
-  for (int i = 0; i < list->count; i++)
+  /* pass 1: same number, names compared; pass 2: same name key, numbers compared */
+  double prepare = secondsSince(&start);
+  clock_gettime(CLOCK_MONOTONIC, &phase);
+  for (int pass = 0; pass < 2; pass++)
   {
-    if (strcasecmp(list->data[i].name, key) == 0)
+    int m = 0;
+    for (int i = 0; i < n; i++)
     {
-      printf("Found: %s - %s\n",
-             list->data[i].name, list->data[i].phone);
-      return;
+      if (list->ids[i] == 0)
+        continue;
+      uint64_t key = pass == 0 ? phoneBlock(phoneKeys[i])
+                     : nameKeys[i][0]
+                         ? checksum64(14695981039346656037ull, nameKeys[i], strlen(nameKeys[i]))
+                         : 0;
+      if (key == 0)
+        continue;
+      entries[m].key = key;
+      entries[m].order = pass == 0 ? keyPrefix(nameKeys[i]) : phoneKeys[i];
+      entries[m].slot = i;
+      m++;
     }
+    runBlocking(&proto, entries, m, work[pass], threads);
   }
-  printf("Contact not found.\n");
-}
+  double compare = secondsSince(&phase);
 
-void updateContact(ContactList *list)
-{
-  int index = -1;
-  char key[MAX_NAME_LEN];
-  printf("Enter Name : ");
-  fgets(key, MAX_NAME_LEN, stdin);
-  key[strcspn(key, "\n")] = '\0';
-  for (int i = 0; i < list->count; i++)
+  long comparisons = 0, pairs = 0;
+  for (int pass = 0; pass < 2; pass++)
   {
-    if (strcasecmp(list->data[i].name, key) == 0)
+    for (int t = 0; t < threads; t++)
     {
-      index = i;
-      break;
+      DedupWork *w = &work[pass][t];
+      for (long p = 0; p < w->pairCount; p++)
+      {
+        int a = findRoot(parent, w->pairs[p * 2]);
+        int b = findRoot(parent, w->pairs[p * 2 + 1]);
+        if (a == b)
+          continue;
+        if (list->ids[a] < list->ids[b])
+          parent[b] = a;
+        else
+          parent[a] = b;
+      }
+      comparisons += w->comparisons;
+      pairs += w->pairCount;
+      free(w->pairs);
     }
   }
 
-  if (index == -1)
-    return;
-
-  char name[MAX_NAME_LEN];
-  char phoneNumber[MAX_PHONE_LEN];
-  int i, flag = 0;
-
-  printf("\nEnter New Name (if you want to change it otherwise skip)         :: ");
-  fgets(name, MAX_NAME_LEN, stdin);
-  if (!((i = strcspn(name, "\n")) < 1))
+  /* every non-root is a duplicate of its root, which holds the lowest id */
+  int clusters = 0, shown = 0;
+  long duplicates = 0;
+  for (int i = 0; i < n; i++)
   {
-    name[i] = 0;
-    strcpy(list->data[index].name, name);
-    flag = 1;
+    if (list->ids[i] == 0)
+      continue;
+    int root = findRoot(parent, i);
+    if (root == i)
+      continue;
+    if (!clustered[root])
+    {
+      clustered[root] = 1;
+      clusters++;
+    }
+    doomed[duplicates++] = list->ids[i];
+    if (shown < DEDUP_SHOW)
+    {
+      Contact c = contactAt(list, i), keep = contactAt(list, root);
+      printf("%d. %s | %s  duplicates  %d. %s | %s\n", list->ids[i], c.name, c.phone,
+             list->ids[root], keep.name, keep.phone);
+      shown++;
+    }
   }
-  printf("Enter New Phone Number (if you want to change it otherwise skip) ::");
-  fgets(phoneNumber, MAX_PHONE_LEN, stdin);
-  if (!((i = strcspn(phoneNumber, "\n")) < 1))
+  double total = secondsSince(&start);
+
+  printf("%d live contact(s): %ld duplicate(s) in %d cluster(s)\n",
+         n - list->tombstones, duplicates, clusters);
+  printf("%ld comparison(s), %ld matching pair(s) on %d thread(s)\n",
+         comparisons, pairs, threads);
+  printf("prepare %.3f s, block + compare %.3f s, total %.3f s\n",
+         prepare, compare, total);
+
+  if (merge)
   {
-    phoneNumber[i] = 0;
-    strcpy(list->data[index].phone, phoneNumber);
-    flag = 1;
+    /* by id, since deleting may compact the list under us */
+    ensureIndexes(list);
+    for (long d = 0; d < duplicates; d++)
+    {
+      int slot = slotForId(list, doomed[d]);
+      if (slot != -1)
+        removeContact(list, slot);
+    }
+    printf("Merged: removed %ld duplicate(s)\n", duplicates);
   }
 
-  if (flag)
+  free(nameKeys);
+  free(phoneKeys);
+  free(entries);
+  free(parent);
+  free(doomed);
+  free(clustered);
+}
+
+/* ===================== Self Check ===================== */
+
+typedef struct
+{
+  int passed;
+  int failed;
+} CheckRun;
+
+static void expect(CheckRun *run, bool ok, const char *what)
+{
+  if (ok)
+    run->passed++;
+  else
+    run->failed++;
+  printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+}
+
+static void removeDataFiles(void)
+{
+  remove(DATA_FILE);
+  remove(TEMP_FILE);
+  remove(JOURNAL_FILE);
+  remove(JOURNAL_OLD_FILE);
+}
+
+/* Loads the files the way startup does */
+static void reloadList(ContactList *list)
+{
+  freeList(list);
+  initList(list);
+  loadFromFile(list);
+  journalReplay(list);
+  ensureIndexes(list);
+}
+
+static Contact checkContact(const char *name, const char *phone)
+{
+  Contact c;
+  memset(&c, 0, sizeof(c));
+  strncpy(c.name, name, MAX_NAME_LEN - 1);
+  strncpy(c.phone, phone, MAX_PHONE_LEN - 1);
+  return c;
+}
+
+/* True when loading the files in a child process ends in a refusal */
+static bool loadRefused(void)
+{
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
   {
-    printf("Changes are saved successfully\n");
+    ContactList list;
+    initList(&list);
+    loadFromFile(&list);
+    ensureIndexes(&list);
+    _exit(0);
   }
-  else
+  int status;
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+         WEXITSTATUS(status) != 0;
+}
+
+static void checkSnapshotIds(CheckRun *run)
+{
+  ContactList list;
+  removeDataFiles();
+  initList(&list);
+  Contact a = checkContact("Check A", "1111111"), b = checkContact("Check B", "2222222");
+  insertContact(&list, &a);
+  insertContact(&list, &b);
+  removeContact(&list, slotForId(&list, 1));
+  removeContact(&list, slotForId(&list, 2));
+  saveToFile(&list);
+
+  reloadList(&list);
+  Contact c = checkContact("Check C", "3333333");
+  expect(run, insertContact(&list, &c) == 3,
+         "ids stay retired after a snapshot with no contacts");
+  saveToFile(&list);
+  freeList(&list);
+
+  /* a damaged nextId must fail the checksum, not renumber contacts */
+  FILE *fp = fopen(DATA_FILE, "r+b");
+  uint32_t nextId = 2;
+  bool patched = fp && fseek(fp, offsetof(SnapshotHeader, nextId), SEEK_SET) == 0 &&
+                 fwrite(&nextId, sizeof(nextId), 1, fp) == 1;
+  if (fp)
+    fclose(fp);
+  expect(run, patched && loadRefused(), "a snapshot with a damaged nextId is refused");
+
+  /* a damaged contact is caught by the first pass over the columns */
+  ContactList damaged;
+  initList(&damaged);
+  Contact d = checkContact("Check D", "4444444");
+  insertContact(&damaged, &d);
+  saveToFile(&damaged);
+  freeList(&damaged);
+  fp = fopen(DATA_FILE, "r+b");
+  patched = fp && fseek(fp, sizeof(SnapshotHeader), SEEK_SET) == 0 && fputc('5', fp) != EOF;
+  if (fp)
+    fclose(fp);
+  expect(run, patched && loadRefused(), "a snapshot with a damaged contact is refused");
+}
+
+/* Writes contacts.dat in the version 2 row layout */
+static bool writeRowSnapshot(const Contact *rows, const int *ids, int count, int nextId)
+{
+  SnapshotHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, SNAPSHOT_MAGIC, 4);
+  h.version = 2;
+  h.count = count;
+  h.nextId = nextId;
+  h.recordSize = sizeof(Contact);
+  h.checksum = checksum64(snapshotSeed(&h), rows, sizeof(Contact) * count);
+  h.checksum = checksum64(h.checksum, ids, sizeof(int) * count);
+
+  static const char pad[sizeof(int)] = {0};
+  size_t records = ROW_HEADER_SIZE + sizeof(Contact) * count;
+  size_t padding = ALIGN_UP(records, sizeof(int)) - records;
+  FILE *fp = fopen(DATA_FILE, "wb");
+  bool ok = fp && fwrite(&h, ROW_HEADER_SIZE, 1, fp) == 1 &&
+            fwrite(rows, sizeof(Contact), count, fp) == (size_t)count &&
+            fwrite(pad, 1, padding, fp) == padding &&
+            fwrite(ids, sizeof(int), count, fp) == (size_t)count;
+  if (fp && fclose(fp) != 0)
+    ok = false;
+  return ok;
+}
+
+static bool sameContact(const ContactList *list, int slot, const Contact *c)
+{
+  Contact got = contactAt(list, slot);
+  return slot != -1 && strcmp(got.name, c->name) == 0 && strcmp(got.phone, c->phone) == 0;
+}
+
+static void checkColumns(CheckRun *run)
+{
+  ContactList list;
+  removeDataFiles();
+  initList(&list);
+  Contact a = checkContact("Same Name", "0012345"), b = checkContact("Same Name", "99");
+  Contact odd = checkContact("Odd Number", "+91 98-76");
+  insertContact(&list, &a);
+  insertContact(&list, &b);
+  insertContact(&list, &odd);
+  expect(run, list.nameAt[0] == list.nameAt[1], "equal names share one copy in the arena");
+
+  saveToFile(&list);
+  reloadList(&list);
+  expect(run, sameContact(&list, slotForId(&list, 1), &a) &&
+                  sameContact(&list, slotForId(&list, 2), &b) &&
+                  sameContact(&list, slotForId(&list, 3), &odd) &&
+                  list.nameAt[slotForId(&list, 1)] == list.nameAt[slotForId(&list, 2)] &&
+                  phoneFind(&list, "919876") == slotForId(&list, 3),
+         "columns and spilled numbers survive a snapshot");
+
+  /* renames leave dead names behind until the arena is repacked */
+  char name[24];
+  for (int round = 0; round < 200; round++)
   {
-    printf("No changes made\n");
+    snprintf(name, sizeof(name), "Renamed Contact %d", round);
+    Contact c = checkContact(name, "12345");
+    replaceContact(&list, slotForId(&list, 3), &c);
   }
+  Contact last = checkContact(name, "12345");
+  expect(run, list.arenaUsed < 200 * strlen(name) / 2 &&
+                  sameContact(&list, slotForId(&list, 3), &last) &&
+                  sameContact(&list, indexFind(&list, "same name"), &a),
+         "updates give their old names back to the arena");
+  freeList(&list);
+
+  /* rows from before the column layout are converted on load */
+  Contact rows[2] = {checkContact("Row One", "111"), checkContact("Row Two", "2-2")};
+  int ids[2] = {2, 4};
+  bool written = writeRowSnapshot(rows, ids, 2, 6);
+  initList(&list);
+  reloadList(&list);
+  Contact c = checkContact("Row Three", "333");
+  expect(run, written && sameContact(&list, slotForId(&list, 2), &rows[0]) &&
+                  sameContact(&list, slotForId(&list, 4), &rows[1]) &&
+                  insertContact(&list, &c) == 6,
+         "a version 2 snapshot converts to columns");
+  freeList(&list);
 }
 
-void deleteContact(ContactList *list)
+static long fileSize(const char *path)
 {
-  int index;
-  printf("\nEnter contact number to delete: ");
-  scanf("%d", &index);
-  clearInputBuffer();
+  struct stat st;
+  return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+/* Drops the journal descriptor without saving, as a crash would */
+static void crashList(ContactList *list)
+{
+  close(list->journal.fd);
+  list->journal.fd = -1;
+}
+
+static void checkJournalRecovery(CheckRun *run)
+{
+  ContactList list;
+  removeDataFiles();
+  initList(&list);
+  journalOpen(&list);
+  Contact a = checkContact("Journal A", "1111111"), b = checkContact("Journal B", "2222222");
+  insertContact(&list, &a);
+  journalCommit(&list);
+  crashList(&list);
+  reloadList(&list);
+  expect(run, indexFind(&list, a.name) != -1, "a committed add survives a crash");
 
-  if (index < 1 || index > list->count)
+  /* half a record, as left by a crash mid-write */
+  FILE *fp = fopen(JOURNAL_FILE, "ab");
+  static const char torn[sizeof(JournalRecord) / 2] = {1};
+  if (fp)
   {
-    printf("Invalid index\n");
-    return;
+    fwrite(torn, 1, sizeof(torn), fp);
+    fclose(fp);
   }
+  reloadList(&list);
+  expect(run, indexFind(&list, a.name) != -1 &&
+                  fileSize(JOURNAL_FILE) == (long)sizeof(JournalRecord),
+         "a torn journal tail is dropped on replay");
 
-  for (int i = index - 1; i < list->count - 1; i++)
-    list->data[i] = list->data[i + 1];
+  /* a snapshot that cannot be written must leave the journal alone */
+  journalOpen(&list);
+  insertContact(&list, &b);
+  journalCommit(&list);
+  mkdir(TEMP_FILE, 0755);
+  long before = fileSize(JOURNAL_FILE);
+  bool saved = checkpoint(&list);
+  expect(run, !saved && fileSize(JOURNAL_FILE) == before,
+         "a failed checkpoint keeps the journal");
+  crashList(&list);
+  rmdir(TEMP_FILE);
+  reloadList(&list);
+  expect(run, indexFind(&list, a.name) != -1 && indexFind(&list, b.name) != -1,
+         "changes survive a failed checkpoint and a crash");
 
-  list->count--;
-  printf("Contact deleted successfully\n");
+  journalOpen(&list);
+  saved = checkpoint(&list);
+  crashList(&list);
+  reloadList(&list);
+  expect(run, saved && fileSize(JOURNAL_FILE) == 0 && indexFind(&list, a.name) != -1 &&
+                  indexFind(&list, b.name) != -1,
+         "a checkpoint folds the journal into the snapshot");
+
+  /* a server snapshot that never finished leaves the older journal set aside */
+  journalOpen(&list);
+  Contact older = checkContact("Journal A", "3333333"), newer = checkContact("Journal A", "4444444");
+  replaceContact(&list, indexFind(&list, a.name), &older);
+  journalCommit(&list);
+  bool aside = journalSetAside(&list);
+  replaceContact(&list, indexFind(&list, a.name), &newer);
+  journalCommit(&list);
+  crashList(&list);
+  reloadList(&list);
+  char phone[MAX_PHONE_LEN];
+  expect(run, aside && strcmp(phoneOf(&list, indexFind(&list, a.name), phone), newer.phone) == 0 &&
+                  access(JOURNAL_OLD_FILE, F_OK) != 0 &&
+                  fileSize(JOURNAL_FILE) == 2 * (long)sizeof(JournalRecord),
+         "a set-aside journal replays first and is merged back");
+  freeList(&list);
 }
 
-/* ===================== File Handling ===================== */
+static uint32_t checkRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
 
-void saveToFile(const ContactList *list)
+/* Fills a field with digits, separators, other bytes and maybe a NUL */
+static void randomField(char *field, size_t width, uint32_t *state)
 {
-  FILE *fp = fopen(DATA_FILE, "wb");
-  if (!fp)
-    return;
+  static const char alphabet[] = "0123456789+- x/\x7f";
+  for (size_t k = 0; k < width; k++)
+    field[k] = alphabet[checkRandom(state) % (sizeof(alphabet) - 1)];
+  uint32_t r = checkRandom(state) % 8;
+  if (r == 0)
+    return; /* no terminator at all */
+  size_t len = r == 1 ? width - 1 : checkRandom(state) % width;
+  if (r <= 4)
+    memset(field, '0' + (char)(checkRandom(state) % 10), len); /* mostly valid */
+  memset(field + len, 0, width - len);
+}
 
-  fwrite(&list->count, sizeof(int), 1, fp);
-  fwrite(list->data, sizeof(Contact), list->count, fp);
-  fclose(fp);
+/*
+ * Differential check of the batch phone kernels against the scalar rules,
+ * over widths 1-16 and strides that pack fields tightly or leave gaps. Each
+ * array is allocated to end exactly at its last field, so a load past the
+ * final records shows up under a sanitizer.
+ */
+static void checkPhoneBatch(CheckRun *run)
+{
+  uint32_t state = 2463534242u;
+  long mismatches = 0, fields = 0;
+  for (size_t width = 1; width <= PHONE_FIELD_MAX; width++)
+  {
+    size_t strides[] = {width, width + 3, sizeof(Contact)};
+    for (int s = 0; s < 3; s++)
+    {
+      size_t stride = strides[s] < width ? width : strides[s];
+      for (int n = 1; n <= 40; n++)
+      {
+        size_t bytes = (size_t)(n - 1) * stride + width;
+        char *base = (char *)malloc(bytes), *copy = (char *)malloc(bytes);
+        unsigned char ok[40];
+        if (!base || !copy)
+        {
+          printf("Memory allocation failed\n");
+          exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < n; i++)
+          randomField(base + i * stride, width, &state);
+
+        for (int rule = PHONE_DIGITS; rule <= PHONE_DIALABLE; rule++)
+        {
+          phoneValidateBatch(base, stride, width, n, (PhoneRule)rule, ok);
+          for (int i = 0; i < n; i++)
+            mismatches += ok[i] != phoneFieldValid(base + i * stride, width, (PhoneRule)rule);
+        }
+
+        memcpy(copy, base, bytes);
+        phoneCanonicalizeBatch(base, stride, width, n, ok);
+        for (int i = 0; i < n; i++)
+        {
+          const char *before = copy + i * stride, *after = base + i * stride;
+          char tmp[PHONE_FIELD_MAX + 1], want[PHONE_FIELD_MAX + 1];
+          int len = -1;
+          const char *end = (const char *)memchr(before, '\0', width);
+          if (end)
+          {
+            memcpy(tmp, before, end - before + 1);
+            len = phoneCanonical(tmp, want, sizeof(want));
+          }
+          bool good = ok[i] == (len >= 0);
+          if (good && len >= 0)
+            good = strncmp(after, want, width) == 0 && memchr(after, '\0', width) != NULL;
+          else if (good)
+            good = memcmp(after, before, width) == 0;
+          mismatches += !good;
+        }
+        fields += n;
+        free(base);
+        free(copy);
+      }
+    }
+  }
+  printf("compared %ld fields, %ld mismatch(es)\n", fields, mismatches);
+  expect(run, mismatches == 0, "batch phone kernels match the scalar rules");
 }
 
-void loadFromFile(ContactList *list)
+/*
+ * contact_management check: runs each behaviour check against fresh files
+ * in a scratch directory and prints PASS or FAIL per check.
+ */
+bool runChecks(void)
 {
-  FILE *fp = fopen(DATA_FILE, "rb");
-  if (!fp)
-    return;
+  char dir[] = "/tmp/contacts-check-XXXXXX";
+  int home = open(".", O_RDONLY);
+  if (home == -1 || mkdtemp(dir) == NULL || chdir(dir) != 0)
+  {
+    printf("Failed to set up a scratch directory\n");
+    return false;
+  }
 
-  fread(&list->count, sizeof(int), 1, fp);
-  fread(list->data, sizeof(Contact), list->count, fp);
-  fclose(fp);
+  CheckRun run = {0, 0};
+  checkSnapshotIds(&run);
+  checkColumns(&run);
+  checkJournalRecovery(&run);
+  checkPhoneBatch(&run);
+
+  removeDataFiles();
+  if (fchdir(home) != 0 || rmdir(dir) != 0)
+    printf("Failed to remove %s\n", dir);
+  close(home);
+  printf("%d passed, %d failed\n", run.passed, run.failed);
+  return run.failed == 0;
 }
 
 /* ===================== Utilities ===================== */
 
 bool validatePhone(const char *phone)
 {
-  for (int i = 0; phone[i]; i++)
-    if (!isdigit(phone[i]))
-      return false;
-  return true;
+  return phoneIsDigits(phone) ? true : false;
 }
 
 void clearInputBuffer(void)
@@ -299,7 +4495,9 @@ void showMenu(void)
   printf("3. Search Contact\n");
   printf("4. Update Contact\n");
   printf("5. Delete Contact\n");
-  printf("6. Exit\n\n");
+  printf("6. Exit\n");
+  printf("7. Smart Search\n");
+  printf("8. Caller ID Lookup\n\n");
   printf("Choose option: ");
 }
 
@@ -312,9 +4510,10 @@ void showMenu(void)
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 1
-
 Enter Name : Nirlova panda
 Enter Phone : 7832019492
 Contact added successfully!
@@ -326,10 +4525,13 @@ Contact added successfully!
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 2
+Sort by (1) Number (2) Name (3) Phone : 1
 
------- Contact List ---------
+------ Contact List (page 1 of 1) ------
 1. Nirlova panda | 7832019492
 
 ==== Contact Management ====
@@ -339,9 +4541,10 @@ Choose option: 2
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 1
-
 Enter Name : Suresh pujari
 Enter Phone : 4839289381
 Contact added successfully!
@@ -353,10 +4556,13 @@ Contact added successfully!
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 2
+Sort by (1) Number (2) Name (3) Phone : 1
 
------- Contact List ------
+------ Contact List (page 1 of 1) ------
 1. Nirlova panda | 7832019492
 2. Suresh pujari | 4839289381
 
@@ -367,9 +4573,10 @@ Choose option: 2
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 3
-
 Search Name : NIRLOVA PANDA
 Found: Nirlova panda - 7832019492
 
@@ -380,10 +4587,12 @@ Found: Nirlova panda - 7832019492
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 4
-
 Enter Name : SURESH PUJARI
+
 Enter New Name (if you want to change it otherwise skip)         ::
 Enter New Phone Number (if you want to change it otherwise skip) ::6793284930
 Changes are saved successfully
@@ -395,10 +4604,13 @@ Changes are saved successfully
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 2
+Sort by (1) Number (2) Name (3) Phone : 1
 
------- Contact List ------
+------ Contact List (page 1 of 1) ------
 1. Nirlova panda | 7832019492
 2. Suresh pujari | 6793284930
 
@@ -409,9 +4621,10 @@ Choose option: 2
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 1
-
 Enter Name : Jasbant sing
 Enter Phone : 8943564839
 Contact added successfully!
@@ -423,12 +4636,16 @@ Contact added successfully!
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
+
 Choose option: 2
+Sort by (1) Number (2) Name (3) Phone : 2
 
------- Contact List ------
+------ Contact List (page 1 of 1) ------
+3. Jasbant sing | 8943564839
 1. Nirlova panda | 7832019492
 2. Suresh pujari | 6793284930
-3. Jasbant sing | 8943564839
 
 ==== Contact Management ====
 1. Add Contact
@@ -437,13 +4654,13 @@ Choose option: 2
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
-Choose option: 2
+Choose option: 5
 
------- Contact List ------
-1. Nirlova panda | 7832019492
-2. Suresh pujari | 6793284930
-3. Jasbant sing | 8943564839
+Enter contact number to delete: 3
+Contact deleted successfully
 
 ==== Contact Management ====
 1. Add Contact
@@ -452,11 +4669,28 @@ Choose option: 2
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
-Choose option: 5
+Choose option: 7
+Search name or phone (prefix, part or typo) : suresh pujri
 
-Enter contact number to delete: 3
-Contact deleted successfully
+------ Best Matches ------
+2. Suresh pujari | 6793284930  (typo)
+
+==== Contact Management ====
+1. Add Contact
+2. View Contacts
+3. Search Contact
+4. Update Contact
+5. Delete Contact
+6. Exit
+7. Smart Search
+8. Caller ID Lookup
+
+Choose option: 8
+Enter Phone : 7832019492
+Caller: 1. Nirlova panda - 7832019492
 
 ==== Contact Management ====
 1. Add Contact
@@ -465,10 +4699,13 @@ Contact deleted successfully
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
 
 Choose option: 2
+Sort by (1) Number (2) Name (3) Phone : 1
 
------- Contact List ------
+------ Contact List (page 1 of 1) ------
 1. Nirlova panda | 7832019492
 2. Suresh pujari | 6793284930
 
@@ -479,7 +4716,10 @@ Choose option: 2
 4. Update Contact
 5. Delete Contact
 6. Exit
+7. Smart Search
+8. Caller ID Lookup
+
 Choose option: 6
 Exiting... Data saved.
 
-*/
\ No newline at end of file
+*/
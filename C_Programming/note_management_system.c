@@ -1,21 +1,95 @@
 //===============================================================================//
 //                             NOTE MANAGEMENT SYSTEM                            //
 //===============================================================================//
+//
+// Build: gcc note_management_system.c -o note_management_system -lm -pthread
+// (stream_load.h and timestamp.h must sit next to this file)
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
 #include <time.h>
-
-#define INITIAL_CAPACITY 5
-#define MAX_TITLE_LEN 50
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "stream_load.h"
+#include "timestamp.h"
+
+#define NOTE_PAGE_BITS 10 /* 1024 headers, 32 KB, per page */
+#define NOTE_PAGE (1 << NOTE_PAGE_BITS)
+#define ARENA_INITIAL_SIZE 4096
+#define MAX_TITLE_LEN 50 /* fixed field sizes of the old notes.dat records */
 #define MAX_CONTENT_LEN 300
 #define MAX_CATEGORY_LEN 30
-#define TIME_LEN 20
+#define TIME_LEN 20 /* text times in version 1 and 2 files */
 #define FILENAME "notes.dat"
+#define FILE_MAGIC "NOTS"
+#define FILE_VERSION 4
+#define TEMP_FILENAME "notes.dat.tmp"
+#define RECORD_MAGIC "NREC"
+#define UPDATE_MAGIC "NUPD" /* the note at position note.text was replaced */
+#define DELETE_MAGIC "NDEL" /* the note at position note.text was deleted */
+#define COMPACT_MIN_RECORDS 256 /* appended notes before a rewrite is considered */
+#define CONVERT_CHUNK 4096      /* version 2 headers converted per read */
+#define TERM_MAX 32        /* longer words are indexed by their first TERM_MAX bytes */
+#define TERMS_INITIAL_SLOTS 1024
+#define TITLE_WEIGHT 2     /* a word in the title counts as this many in the body */
+#define BM25_K1 1.2
+#define BM25_B 0.75
+#define SEARCH_TOP 10
+#define SEARCH_REBUILD_MIN 1024 /* tombstoned docs before the index is rebuilt */
+#define QUERY_LEN 128
+#define CATEGORY_INITIAL_SLOTS 64
+#define PRIORITY_BUCKETS 4 /* 1=High, 2=Medium, 3=Low, then anything else */
+#define ARCHIVE_FILENAME "notes.arc"
+#define ARCHIVE_TEMP_FILENAME "notes.arc.tmp"
+#define ARCHIVE_MAGIC "NARC"
+#define ARCHIVE_VERSION 2
+#define ARCHIVE_BLOCK_SIZE (64 * 1024) /* raw bytes gathered before a block is closed */
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 14
+#define LZ_MAX_OFFSET 65535
+#define NOTE_DELETED 1u
+#define EPOCH_MAX_READERS 64
+#define BENCH_READERS 2
+#define BENCH_SECONDS 2
+#define BENCH_BATCH 64 /* notes a reader looks at per snapshot */
+#define RENDER_BUFFER (1 << 20) /* output gathered per write() */
 
 /* ================= DATA STRUCTURES ================= */
 
+/*
+ * Fixed-size header of a note. Its title, category and content live back
+ * to back in NoteList.arena, each NUL-terminated, starting at text; a note
+ * costs 32 bytes plus its actual text, and content has no length cap.
+ */
+typedef struct
+{
+  uint64_t text;
+  uint16_t titleLen;
+  uint16_t categoryLen;
+  uint32_t contentLen;
+  int64_t created; /* seconds since the epoch */
+  int32_t priority;
+  uint32_t flags; /* NOTE_DELETED; the note keeps its position */
+} Note;
+
+/* Version 2 header, identical except that the time was stored as text */
+typedef struct
+{
+  uint64_t text;
+  uint16_t titleLen;
+  uint16_t categoryLen;
+  uint32_t contentLen;
+  char created_at[TIME_LEN];
+  int32_t priority;
+} NoteV2;
+
+/* Record layout of version 1 notes.dat, still accepted by loadFromFile */
 typedef struct
 {
   char title[MAX_TITLE_LEN];
@@ -23,42 +97,367 @@ typedef struct
   char content[MAX_CONTENT_LEN];
   char created_at[TIME_LEN];
   int priority;
-} Note;
+} LegacyNote;
+
+/*
+ * notes.dat: this header, count Note headers, then arenaSize bytes of text.
+ * Offsets are arena-relative, so loading is two reads straight into place.
+ * Notes added since are NoteRecords appended after that image.
+ */
+typedef struct
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+  uint64_t arenaSize;
+} NoteFileHeader;
+
+/*
+ * One appended note: this record, then textSize bytes holding its three
+ * strings (note.text is 0). A crash can leave only a torn last record,
+ * which the checksum exposes and loading cuts off.
+ */
+typedef struct
+{
+  char magic[4];
+  uint32_t textSize;
+  Note note;
+  uint64_t checksum; /* FNV-1a over the fields above and the text */
+} NoteRecord;
+
+typedef struct
+{
+  char magic[4];
+  uint32_t textSize;
+  NoteV2 note;
+  uint64_t checksum;
+} NoteRecordV2;
+
+/*
+ * Inverted index over title and content. Each term owns a byte string of
+ * (doc delta, term frequency) pairs in LEB128 varints, so a posting
+ * usually costs two bytes. A note is indexed as a doc, numbered in the
+ * order docs are added, so deltas are never negative; an edited or
+ * deleted note's doc is tombstoned and its pairs skipped, and an edited
+ * note comes back as a fresh doc.
+ */
+typedef struct
+{
+  uint32_t hash;
+  uint32_t term; /* offset in SearchIndex.terms, UINT32_MAX when the slot is empty */
+  uint32_t docs; /* live docs holding the term */
+  uint32_t last; /* doc the last pair points at */
+  uint32_t used;
+  uint32_t capacity;
+  uint8_t *bytes;
+} Posting;
+
+typedef struct
+{
+  char term[TERM_MAX + 1];
+  uint32_t hash;
+  int tf;
+} TermCount;
+
+typedef struct
+{
+  Posting *slots;
+  int capacity; /* always a power of two */
+  int used;
+  char *terms; /* NUL-separated term text */
+  size_t termsUsed;
+  size_t termsCapacity;
+  uint16_t *length; /* weighted tokens per doc, for BM25 length normalization */
+  int *noteOf;      /* doc -> note position, -1 once tombstoned */
+  int docs;         /* docs handed out, live or not */
+  int live;         /* docs not tombstoned, the N of BM25 */
+  int docCapacity;
+  int *docOf; /* note position -> its live doc, -1 when it has none */
+  int noteCapacity;
+  uint64_t totalLength; /* over live docs */
+  float *scores; /* per-doc query scratch, all zero between queries */
+  int *touched;
+  TermCount *counts; /* per-note indexing scratch */
+  int countCapacity;
+  int *countSlots; /* term -> its entry in counts, -1 when free; twice countCapacity */
+} SearchIndex;
+
+typedef struct
+{
+  int note;
+  float score;
+} SearchHit;
+
+/* Categories interned to small ids, each with the positions of its notes */
+typedef struct
+{
+  char *name;
+  int *notes; /* ascending */
+  int count;
+  int capacity;
+} Category;
+
+typedef struct
+{
+  uint32_t hash;
+  int id; /* -1 when the slot is empty */
+} CategorySlot;
+
+typedef struct
+{
+  CategorySlot *slots;
+  int slotCapacity; /* always a power of two */
+  Category *list;   /* by id */
+  int count;
+  int capacity;
+} CategoryIndex;
+
+/*
+ * notes.arc: this header, the compressed blocks, then one ArchiveBlock per
+ * block. A block holds whole notes as their Note headers (text relative to
+ * the block's text) followed by their text, so any note can be read by
+ * decompressing just the block that holds it.
+ */
+typedef struct
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t blockCount;
+  uint64_t directory; /* file offset of the block directory */
+} ArchiveHeader;
+
+typedef struct
+{
+  uint64_t offset;
+  uint32_t packedSize;
+  uint32_t rawSize;
+  uint32_t firstNote;
+  uint32_t noteCount;
+  uint64_t checksum; /* blockChecksum of the compressed bytes */
+} ArchiveBlock;
+
+/* What readers see: the notes as they were at one publishSnapshot, never changed after */
+typedef struct
+{
+  const Note *const *pages; /* as in NoteList */
+  int count;
+  const char *arena;
+} NoteSnapshot;
+
+typedef struct
+{
+  void *memory;
+  uint64_t epoch; /* global epoch when it was retired */
+} Retired;
+
+typedef struct
+{
+  _Alignas(64) _Atomic uint64_t epoch; /* 0 while the reader holds no snapshot */
+} EpochSlot;
 
+/*
+ * Epoch-based reclamation. A reader copies the global epoch into its slot
+ * for as long as it holds a snapshot; memory retired at epoch e is freed
+ * once every reader inside has a slot above e.
+ */
+typedef struct
+{
+  _Atomic uint64_t global;
+  _Atomic int readers; /* slots handed out */
+  EpochSlot slots[EPOCH_MAX_READERS];
+  void **pending; /* replaced, but maybe still in the published snapshot */
+  int pendingCount;
+  int pendingCapacity;
+  Retired *retired;
+  int retiredCount;
+  int retiredCapacity;
+} EpochDomain;
+
+/* Note positions, kept in whatever order the owning index needs */
 typedef struct
 {
-  Note *notes;
+  int *notes;
   int count;
   int capacity;
+} NoteRefs;
+
+/*
+ * Note headers live in pages of NOTE_PAGE, so that changing one copies
+ * only its page (and the page table) rather than every header.
+ */
+typedef struct
+{
+  Note **pages;
+  uint64_t *pageCopied; /* snapshot number each page was last copied in */
+  int *pageDeleted;     /* deleted notes in each page, so listings skip pages whole */
+  int pageCount;
+  int pageCapacity;
+  uint64_t tableCopied; /* likewise for pages itself */
+  uint64_t snapshots;   /* publishSnapshot calls so far */
+  int count;
+  int capacity; /* notes that fit in the pages allocated */
+  char *arena;
+  size_t arenaUsed;
+  size_t arenaCapacity;
+  SearchIndex search;
+  CategoryIndex categories;
+  NoteRefs byTime;                       /* ascending (created, position) */
+  NoteRefs byPriority[PRIORITY_BUCKETS]; /* each in the order notes were added */
+  int searchReady; /* the index is built on the first search, then kept current */
+  int saved;       /* notes in the image part of notes.dat */
+  int appended;    /* notes in records after it */
+  int appendable;  /* notes.dat is a clean current-version file */
+  int archived;    /* notes.arc is the live file, rewritten whole on every change */
+  _Atomic(NoteSnapshot *) current;
+  EpochDomain epochs;
 } NoteList;
 
 /* ================= FUNCTION PROTOTYPES ================= */
 
 void initNoteList(NoteList *list);
+Note *noteAt(const NoteList *list, int pos);
+const Note *snapshotNote(const NoteSnapshot *s, int pos);
 void freeNoteList(NoteList *list);
 void resizeNoteList(NoteList *list);
+int appendNote(NoteList *list, const char *title, const char *category,
+               const char *content, int64_t created, int priority);
+const char *noteTitle(const NoteList *list, const Note *n);
+const char *noteCategory(const NoteList *list, const Note *n);
+const char *noteContent(const NoteList *list, const Note *n);
+int updateNote(NoteList *list, int pos, const char *title, const char *category,
+               const char *content, int priority);
+int deleteNote(NoteList *list, int pos);
+void publishSnapshot(NoteList *list);
+int snapshotReader(NoteList *list);
+const NoteSnapshot *snapshotEnter(NoteList *list, int reader);
+void snapshotLeave(NoteList *list, int reader);
+void runBenchmark(NoteList *list, int readers, int seconds);
 
 void addNote(NoteList *list);
+void editNote(NoteList *list);
+void removeNote(NoteList *list);
 void displayAllNotes(NoteList *list);
+void renderNotes(const NoteList *list, long offset, long limit, int fd);
+void runRenderBenchmark(const NoteList *list);
 void displayNotesByCategory(NoteList *list);
+void searchNotes(NoteList *list);
+void ensureSearch(NoteList *list);
+void listCategories(NoteList *list);
+void showTopPriority(NoteList *list);
+void showBetween(NoteList *list);
+void showLatest(NoteList *list);
+void indexNote(NoteList *list, int pos);
+void unindexNote(NoteList *list, int pos);
+
+void categoryInit(CategoryIndex *idx);
+void categoryFree(CategoryIndex *idx);
+int categoryAdd(CategoryIndex *idx, const char *name, int note);
+void categoryRemove(CategoryIndex *idx, const char *name, int note);
+const Category *categoryFind(const CategoryIndex *idx, const char *name);
+
+void searchInit(SearchIndex *idx);
+void searchFree(SearchIndex *idx);
+void searchAdd(SearchIndex *idx, int note, const char *title, const char *content);
+void searchRemove(SearchIndex *idx, int note, const char *title, const char *content);
+int searchQuery(SearchIndex *idx, const char *query, SearchHit *hits, int k);
+void showHits(const NoteList *list, const SearchHit *hits, int n);
 
 void saveToFile(NoteList *list);
+void appendToFile(NoteList *list);
+void appendChange(NoteList *list, const char *magic, int pos);
 void loadFromFile(NoteList *list);
 
+size_t lzCompress(const uint8_t *src, size_t n, uint8_t *dst);
+long lzDecompress(const uint8_t *src, size_t n, uint8_t *dst, size_t capacity);
+uint64_t writeArchive(NoteList *list);
+void saveArchive(NoteList *list);
+int loadArchive(NoteList *list);
+void showArchivedNote(long number);
+
 void displayMenu();
 int getChoice();
 void clearBuffer();
-void getCurrentTime(char *timeStr);
+char *readLine(char **buf, size_t *size);
+int readCount(const char *prompt);
 
 /* ================= MAIN ================= */
 
-int main()
+int main(int argc, char *argv[])
 {
   NoteList notes;
   int choice;
 
+  /* note_management_system show <n>: reads one note from the archive alone */
+  if (argc == 3 && strcmp(argv[1], "show") == 0)
+  {
+    showArchivedNote(atol(argv[2]));
+    return 0;
+  }
+
   initNoteList(&notes);
   loadFromFile(&notes);
+  publishSnapshot(&notes);
+
+  if (argc == 2 && strcmp(argv[1], "archive") == 0)
+  {
+    saveArchive(&notes);
+    freeNoteList(&notes);
+    return 0;
+  }
+
+  /* note_management_system list [--offset N] [--limit N] */
+  if (argc >= 2 && strcmp(argv[1], "list") == 0)
+  {
+    long offset = 0, limit = -1;
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+      if (strcmp(argv[i], "--offset") == 0)
+        offset = atol(argv[i + 1]);
+      else if (strcmp(argv[i], "--limit") == 0)
+        limit = atol(argv[i + 1]);
+    }
+    renderNotes(&notes, offset, limit, STDOUT_FILENO);
+    freeNoteList(&notes);
+    return 0;
+  }
+
+  if (argc == 2 && strcmp(argv[1], "bench-render") == 0)
+  {
+    runRenderBenchmark(&notes);
+    freeNoteList(&notes);
+    return 0;
+  }
+
+  /* note_management_system bench [readers] [seconds]: nothing is saved */
+  if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+  {
+    runBenchmark(&notes, argc > 2 ? atoi(argv[2]) : BENCH_READERS,
+                 argc > 3 ? atoi(argv[3]) : BENCH_SECONDS);
+    freeNoteList(&notes);
+    return 0;
+  }
+
+  /* one-shot query: note_management_system search <words...> */
+  if (argc >= 3 && strcmp(argv[1], "search") == 0)
+  {
+    char query[QUERY_LEN] = "";
+    for (int i = 2; i < argc; i++)
+    {
+      strncat(query, argv[i], sizeof(query) - strlen(query) - 2);
+      strcat(query, " ");
+    }
+    SearchHit hits[SEARCH_TOP];
+    ensureSearch(&notes);
+    clock_t start = clock();
+    int n = searchQuery(&notes.search, query, hits, SEARCH_TOP);
+    double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    showHits(&notes, hits, n);
+    printf("\n%d hit(s) among %d notes in %.2f ms\n", n, notes.count, ms);
+    freeNoteList(&notes);
+    return 0;
+  }
 
   printf("\n=== NOTE MANAGEMENT SYSTEM ===\n");
 
@@ -71,7 +470,7 @@ int main()
     {
     case 1:
       addNote(&notes);
-      saveToFile(&notes);
+      appendToFile(&notes);
       break;
 
     case 2:
@@ -83,11 +482,38 @@ int main()
       break;
 
     case 4:
-      saveToFile(&notes);
       freeNoteList(&notes);
       printf("\nExiting... Goodbye!\n");
       return 0;
 
+    case 5:
+      searchNotes(&notes);
+      break;
+
+    case 6:
+      listCategories(&notes);
+      break;
+
+    case 7:
+      showTopPriority(&notes);
+      break;
+
+    case 8:
+      showBetween(&notes);
+      break;
+
+    case 9:
+      showLatest(&notes);
+      break;
+
+    case 10:
+      editNote(&notes);
+      break;
+
+    case 11:
+      removeNote(&notes);
+      break;
+
     default:
       printf("Invalid choice!\n");
     }
@@ -98,180 +524,2424 @@ int main()
 
 void initNoteList(NoteList *list)
 {
-  list->capacity = INITIAL_CAPACITY;
+  list->pageCapacity = 1;
+  list->pageCount = 0;
+  list->tableCopied = 0;
+  list->snapshots = 0;
+  list->capacity = 0;
   list->count = 0;
-  list->notes = (Note *)malloc(sizeof(Note) * list->capacity);
-  if (list->notes == NULL)
+  list->arenaUsed = 0;
+  list->arenaCapacity = ARENA_INITIAL_SIZE;
+  list->searchReady = 0;
+  list->saved = 0;
+  list->appended = 0;
+  list->appendable = 0;
+  list->archived = 0;
+  list->pages = (Note **)malloc(sizeof(Note *) * list->pageCapacity);
+  list->pageCopied = (uint64_t *)malloc(sizeof(uint64_t) * list->pageCapacity);
+  list->pageDeleted = (int *)malloc(sizeof(int) * list->pageCapacity);
+  list->arena = (char *)malloc(list->arenaCapacity);
+  if (list->pages == NULL || list->pageCopied == NULL || list->pageDeleted == NULL ||
+      list->arena == NULL)
   {
     printf("Memory allocation failed try again!\n");
     exit(1);
   }
+  searchInit(&list->search);
+  categoryInit(&list->categories);
+  memset(&list->byTime, 0, sizeof(list->byTime));
+  memset(list->byPriority, 0, sizeof(list->byPriority));
+  memset(&list->epochs, 0, sizeof(list->epochs));
+  atomic_init(&list->epochs.global, 1);
+  atomic_init(&list->current, NULL);
+  publishSnapshot(list);
+}
+
+/*
+ * Frees old once no reader can reach it. The published snapshot may still
+ * point into it, so it is only retired at the next publishSnapshot.
+ */
+static void deferFree(NoteList *list, void *old)
+{
+  EpochDomain *d = &list->epochs;
+  if (d->pendingCount == d->pendingCapacity)
+  {
+    d->pendingCapacity = d->pendingCapacity ? d->pendingCapacity * 2 : 16;
+    d->pending = (void **)realloc(d->pending, sizeof(void *) * d->pendingCapacity);
+    if (d->pending == NULL)
+    {
+      printf("Memory allocation failed for during resize!\n");
+      exit(1);
+    }
+  }
+  d->pending[d->pendingCount++] = old;
+}
+
+/* A larger copy of old holding its first keep bytes; old goes through deferFree */
+static void *replaceBuffer(NoteList *list, void *old, size_t keep, size_t size)
+{
+  void *fresh = malloc(size);
+  if (fresh == NULL)
+  {
+    printf("Memory allocation failed for during resize!\n");
+    exit(1);
+  }
+  memcpy(fresh, old, keep);
+  deferFree(list, old);
+  return fresh;
 }
 
+/* Adds one page of headers; only a full page table is copied to grow it */
 void resizeNoteList(NoteList *list)
 {
-  list->capacity *= 2;
-  Note *temp = (Note *)realloc(list->notes, sizeof(Note) * list->capacity);
-  if (temp == NULL)
+  if (list->pageCount == list->pageCapacity)
+  {
+    list->pages = (Note **)replaceBuffer(list, list->pages, sizeof(Note *) * list->pageCount,
+                                         sizeof(Note *) * list->pageCapacity * 2);
+    list->tableCopied = list->snapshots;
+    list->pageCapacity *= 2;
+    uint64_t *copied = (uint64_t *)realloc(list->pageCopied, sizeof(uint64_t) * list->pageCapacity);
+    if (copied == NULL)
+    {
+      printf("Memory allocation failed for during resize!\n");
+      exit(1);
+    }
+    list->pageCopied = copied;
+    int *deleted = (int *)realloc(list->pageDeleted, sizeof(int) * list->pageCapacity);
+    if (deleted == NULL)
+    {
+      printf("Memory allocation failed for during resize!\n");
+      exit(1);
+    }
+    list->pageDeleted = deleted;
+  }
+  Note *page = (Note *)malloc(sizeof(Note) * NOTE_PAGE);
+  if (page == NULL)
   {
     printf("Memory allocation failed for during resize!\n");
-    return;
+    exit(1);
   }
-  list->notes = temp;
+  list->pages[list->pageCount] = page;
+  list->pageDeleted[list->pageCount] = 0;
+  list->pageCopied[list->pageCount++] = list->snapshots;
+  list->capacity += NOTE_PAGE;
 }
 
-void addNote(NoteList *list)
+Note *noteAt(const NoteList *list, int pos)
+{
+  return &list->pages[pos >> NOTE_PAGE_BITS][pos & (NOTE_PAGE - 1)];
+}
+
+/* Copies len bytes plus a NUL to the end of the arena; returns their offset */
+static uint64_t arenaPut(NoteList *list, const char *text, size_t len)
+{
+  if (list->arenaUsed + len + 1 > list->arenaCapacity)
+  {
+    size_t capacity = list->arenaCapacity;
+    while (list->arenaUsed + len + 1 > capacity)
+      capacity *= 2;
+    list->arena = (char *)replaceBuffer(list, list->arena, list->arenaUsed, capacity);
+    list->arenaCapacity = capacity;
+  }
+  uint64_t at = list->arenaUsed;
+  memcpy(list->arena + at, text, len);
+  list->arena[at + len] = '\0';
+  list->arenaUsed += len + 1;
+  return at;
+}
+
+/*
+ * Stands in for a note that could not be read: deleted, with empty text.
+ * Update and delete records name notes by position, so it keeps its place.
+ */
+static void notePlaceholder(NoteList *list, int pos)
+{
+  Note *n = noteAt(list, pos);
+  memset(n, 0, sizeof(*n));
+  n->text = arenaPut(list, "", 0);
+  arenaPut(list, "", 0);
+  arenaPut(list, "", 0);
+  n->flags = NOTE_DELETED;
+  list->pageDeleted[pos >> NOTE_PAGE_BITS]++;
+}
+
+/* Stores and indexes one note; returns its position */
+int appendNote(NoteList *list, const char *title, const char *category,
+               const char *content, int64_t created, int priority)
 {
   if (list->count >= list->capacity)
     resizeNoteList(list);
 
-  Note *n = &list->notes[list->count];
+  size_t titleLen = strlen(title), categoryLen = strlen(category);
+  Note *n = noteAt(list, list->count);
+  n->titleLen = (uint16_t)(titleLen > UINT16_MAX ? UINT16_MAX : titleLen);
+  n->categoryLen = (uint16_t)(categoryLen > UINT16_MAX ? UINT16_MAX : categoryLen);
+  n->contentLen = (uint32_t)strlen(content);
+  n->text = arenaPut(list, title, n->titleLen);
+  arenaPut(list, category, n->categoryLen);
+  arenaPut(list, content, n->contentLen);
+  n->created = created;
+  n->priority = priority;
+  n->flags = 0;
+
+  if (list->searchReady)
+    searchAdd(&list->search, list->count, noteTitle(list, n), noteContent(list, n));
+  indexNote(list, list->count);
+  return list->count++;
+}
+
+const char *noteTitle(const NoteList *list, const Note *n)
+{
+  return list->arena + n->text;
+}
+
+const char *noteCategory(const NoteList *list, const Note *n)
+{
+  return list->arena + n->text + n->titleLen + 1;
+}
+
+const char *noteContent(const NoteList *list, const Note *n)
+{
+  return list->arena + n->text + n->titleLen + 1 + n->categoryLen + 1;
+}
+
+/*
+ * Saved files hold only the text live notes point at: a deleted note goes
+ * out with empty text, and every note's offset is rebased to where its
+ * text lands, so edited and deleted text is dropped on each rewrite.
+ */
+static size_t savedTextSize(const Note *n)
+{
+  return n->flags & NOTE_DELETED ? 3 : n->titleLen + n->categoryLen + (size_t)n->contentLen + 3;
+}
+
+static const char *savedText(const NoteList *list, const Note *n)
+{
+  return n->flags & NOTE_DELETED ? "\0\0" : noteTitle(list, n);
+}
+
+static Note savedNote(const Note *n, uint64_t text)
+{
+  Note saved = *n;
+  saved.text = text;
+  if (saved.flags & NOTE_DELETED)
+  {
+    saved.titleLen = saved.categoryLen = 0;
+    saved.contentLen = 0;
+  }
+  return saved;
+}
+
+void addNote(NoteList *list)
+{
+  char *title = NULL, *category = NULL, *content = NULL;
+  size_t titleSize = 0, categorySize = 0, contentSize = 0;
+  int priority = 0;
 
   printf("\nEnter title: ");
-  fgets(n->title, MAX_TITLE_LEN, stdin);
-  n->title[strcspn(n->title, "\n")] = 0;
+  readLine(&title, &titleSize);
 
   printf("Enter category: ");
-  fgets(n->category, MAX_CATEGORY_LEN, stdin);
-  n->category[strcspn(n->category, "\n")] = 0;
+  readLine(&category, &categorySize);
 
   printf("Enter content: ");
-  fgets(n->content, MAX_CONTENT_LEN, stdin);
-  n->content[strcspn(n->content, "\n")] = 0;
+  readLine(&content, &contentSize);
 
   printf("Priority (1=High, 2=Medium, 3=Low): ");
-  scanf("%d", &n->priority);
+  scanf("%d", &priority);
   clearBuffer();
 
-  getCurrentTime(n->created_at);
-
-  list->count++;
+  appendNote(list, title ? title : "", category ? category : "", content ? content : "",
+             timestampNow(), priority);
+  publishSnapshot(list);
+  free(title);
+  free(category);
+  free(content);
   printf("\nNote added successfully!\n");
 }
 
-void displayAllNotes(NoteList *list)
+/* Note pos when number names a live note, else -1 */
+static int livePosition(const NoteList *list, int number)
 {
-  if (list->count == 0)
+  int pos = number - 1;
+  if (pos < 0 || pos >= list->count || (noteAt(list, pos)->flags & NOTE_DELETED))
+    return -1;
+  return pos;
+}
+
+void editNote(NoteList *list)
+{
+  int pos = livePosition(list, readCount("\nEnter note number: "));
+  if (pos < 0)
   {
-    printf("\nNo notes available.\n");
+    printf("\nNo such note.\n");
     return;
   }
+  const Note *n = noteAt(list, pos);
+  printf("\n%s (%s), priority %d\n%s\n", noteTitle(list, n), noteCategory(list, n),
+         n->priority, noteContent(list, n));
+  printf("\nPress Enter to keep a field as it is.\n");
+
+  char *title = NULL, *category = NULL, *content = NULL;
+  size_t titleSize = 0, categorySize = 0, contentSize = 0;
+  printf("New title: ");
+  readLine(&title, &titleSize);
+  printf("New category: ");
+  readLine(&category, &categorySize);
+  printf("New content: ");
+  readLine(&content, &contentSize);
+  int priority = readCount("New priority (1=High, 2=Medium, 3=Low): ");
+
+  /* kept fields point into the arena, which an update never overwrites */
+  updateNote(list, pos, title && *title ? title : noteTitle(list, n),
+             category && *category ? category : noteCategory(list, n),
+             content && *content ? content : noteContent(list, n),
+             priority >= 0 ? priority : n->priority);
+  publishSnapshot(list);
+  appendChange(list, UPDATE_MAGIC, pos);
+  free(title);
+  free(category);
+  free(content);
+  printf("\nNote updated successfully!\n");
+}
 
-  printf("\n=== ALL NOTES ===\n");
-  for (int i = 0; i < list->count; i++)
+void removeNote(NoteList *list)
+{
+  int pos = livePosition(list, readCount("\nEnter note number: "));
+  if (pos < 0)
   {
-    Note *n = &list->notes[i];
-    printf("\n[%d] %s (%s)\n", i + 1, n->title, n->category);
-    printf("Priority: %d\n", n->priority);
-    printf("Created: %s\n", n->created_at);
-    printf("Content: %s\n", n->content);
+    printf("\nNo such note.\n");
+    return;
   }
+  deleteNote(list, pos);
+  publishSnapshot(list);
+  appendChange(list, DELETE_MAGIC, pos);
+  printf("\nNote deleted successfully!\n");
+}
+
+void displayAllNotes(NoteList *list)
+{
+  renderNotes(list, 0, -1, STDOUT_FILENO);
 }
 
 void displayNotesByCategory(NoteList *list)
 {
-  char category[MAX_CATEGORY_LEN];
-  int found = 0;
+  char *category = NULL;
+  size_t size = 0;
 
   printf("\nEnter category to search: ");
-  fgets(category, MAX_CATEGORY_LEN, stdin);
-  category[strcspn(category, "\n")] = 0;
+  readLine(&category, &size);
 
-  for (int i = 0; i < list->count; i++)
+  const Category *c = category ? categoryFind(&list->categories, category) : NULL;
+  free(category);
+  if (!c)
   {
-    if (strcmp(list->notes[i].category, category) == 0)
-    {
-      Note *n = &list->notes[i];
-      printf("\n%s - %s\n", n->title, n->created_at);
-      printf("%s\n", n->content);
-      found = 1;
-    }
+    printf("\nNo notes found in this category.\n");
+    return;
   }
 
-  if (!found)
-    printf("\nNo notes found in this category.\n");
+  for (int i = 0; i < c->count; i++)
+  {
+    Note *n = noteAt(list, c->notes[i]);
+    char created_at[TIMESTAMP_LEN];
+    timestampText(n->created, created_at);
+    printf("\n%s - %s\n", noteTitle(list, n), created_at);
+    printf("%s\n", noteContent(list, n));
+  }
 }
 
-void saveToFile(NoteList *list)
+static int compareCategoryNames(const void *a, const void *b)
 {
-  FILE *fp = fopen(FILENAME, "wb");
-  if (!fp)
+  return strcmp((*(const Category *const *)a)->name, (*(const Category *const *)b)->name);
+}
+
+void listCategories(NoteList *list)
+{
+  const CategoryIndex *idx = &list->categories;
+  if (idx->count == 0)
   {
-    printf("Failed to save data!\n");
+    printf("\nNo notes available.\n");
     return;
   }
-  fwrite(&list->count, sizeof(int), 1, fp);
-  fwrite(list->notes, sizeof(Note), list->count, fp);
-  fclose(fp);
+
+  const Category **sorted = (const Category **)malloc(sizeof(Category *) * idx->count);
+  if (sorted == NULL)
+    return;
+  for (int i = 0; i < idx->count; i++)
+    sorted[i] = &idx->list[i];
+  qsort(sorted, idx->count, sizeof(Category *), compareCategoryNames);
+
+  printf("\n=== CATEGORIES ===\n");
+  for (int i = 0; i < idx->count; i++)
+    if (sorted[i]->count > 0)
+      printf("%-30s %d\n", sorted[i]->name[0] ? sorted[i]->name : "(none)", sorted[i]->count);
+  free(sorted);
 }
 
-void loadFromFile(NoteList *list)
+void searchNotes(NoteList *list)
 {
-  FILE *fp = fopen(FILENAME, "rb");
-  if (!fp)
+  char query[QUERY_LEN];
+  SearchHit hits[SEARCH_TOP];
+
+  printf("\nSearch words: ");
+  fgets(query, QUERY_LEN, stdin);
+  query[strcspn(query, "\n")] = 0;
+
+  ensureSearch(list);
+  int n = searchQuery(&list->search, query, hits, SEARCH_TOP);
+  if (n == 0)
   {
-    printf("Failed to load file!\n");
+    printf("\nNo matching notes.\n");
     return;
   }
-
-  fread(&list->count, sizeof(int), 1, fp);
-  while (list->count > list->capacity)
-    resizeNoteList(list);
-
-  fread(list->notes, sizeof(Note), list->count, fp);
-  fclose(fp);
+  showHits(list, hits, n);
 }
 
-void displayMenu()
+void ensureSearch(NoteList *list)
 {
-  printf("\n1. Add Note");
-  printf("\n2. View All Notes");
-  printf("\n3. View Notes by Category");
-  printf("\n4. Exit");
-  printf("\nEnter choice: ");
+  if (list->searchReady)
+    return;
+  for (int i = 0; i < list->count; i++)
+  {
+    const Note *n = noteAt(list, i);
+    if (!(n->flags & NOTE_DELETED))
+      searchAdd(&list->search, i, noteTitle(list, n), noteContent(list, n));
+  }
+  list->searchReady = 1;
 }
 
-int getChoice()
+void showHits(const NoteList *list, const SearchHit *hits, int n)
 {
-  int ch;
-  while (scanf("%d", &ch) != 1)
+  for (int i = 0; i < n; i++)
   {
-    printf("Enter a valid number between 1-4!\n");
-    clearBuffer();
+    const Note *note = noteAt(list, hits[i].note);
+    printf("\n[%d] %s (%s)  score %.2f\n", hits[i].note + 1, noteTitle(list, note),
+           noteCategory(list, note), hits[i].score);
+    printf("%s\n", noteContent(list, note));
   }
-  clearBuffer();
-  return ch;
 }
 
-void clearBuffer()
+static uint64_t checksum64(uint64_t h, const void *buf, size_t len)
 {
-  while (getchar() != '\n')
-    ;
+  const unsigned char *p = (const unsigned char *)buf;
+  for (size_t i = 0; i < len; i++)
+  {
+    h ^= p[i];
+    h *= 1099511628211ull;
+  }
+  return h;
 }
 
-void getCurrentTime(char *timeStr)
+static uint64_t recordChecksum(const NoteRecord *r, const char *text)
 {
-  time_t now = time(NULL);
-  struct tm *t = localtime(&now);
-  strftime(timeStr, TIME_LEN, "%Y-%m-%d %H:%M:%S", t);
+  uint64_t h = checksum64(14695981039346656037ull, r, offsetof(NoteRecord, checksum));
+  return checksum64(h, text, r->textSize);
 }
 
-void freeNoteList(NoteList *list)
+/* Flushes fp all the way to the disk; 0 on success */
+static int syncFile(FILE *fp)
 {
-  free(list->notes);
+  return fflush(fp) != 0 || fsync(fileno(fp)) != 0;
 }
 
-// Output
-/*
-=== NOTE MANAGEMENT SYSTEM ===
+/* Rewrites the whole file as one image; the old one stays until the rename */
+void saveToFile(NoteList *list)
+{
+  if (list->archived)
+  {
+    if (!writeArchive(list))
+      printf("Failed to save data!\n");
+    return;
+  }
 
-1. Add Note
-2. View All Notes
-3. View Notes by Category
-4. Exit
-Enter choice: 1
+  FILE *fp = fopen(TEMP_FILENAME, "wb");
+  if (!fp)
+  {
+    printf("Failed to save data!\n");
+    return;
+  }
+  NoteFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, FILE_MAGIC, 4);
+  h.version = FILE_VERSION;
+  h.count = (uint32_t)list->count;
+  for (int i = 0; i < list->count; i++)
+    h.arenaSize += savedTextSize(noteAt(list, i));
+  int failed = fwrite(&h, sizeof(h), 1, fp) != 1;
 
-Enter title: Meeting Notes
+  Note chunk[256];
+  uint64_t text = 0;
+  for (int done = 0; done < list->count && !failed; done += 256)
+  {
+    size_t n = list->count - done < 256 ? (size_t)(list->count - done) : 256;
+    for (size_t i = 0; i < n; i++)
+    {
+      const Note *note = noteAt(list, done + (int)i);
+      chunk[i] = savedNote(note, text);
+      text += savedTextSize(note);
+    }
+    failed = fwrite(chunk, sizeof(Note), n, fp) != n;
+  }
+  for (int i = 0; i < list->count && !failed; i++)
+  {
+    const Note *note = noteAt(list, i);
+    size_t len = savedTextSize(note);
+    failed = fwrite(savedText(list, note), 1, len, fp) != len;
+  }
+  failed = failed || syncFile(fp);
+  if (fclose(fp) != 0 || failed || rename(TEMP_FILENAME, FILENAME) != 0)
+  {
+    printf("Failed to save data!\n");
+    remove(TEMP_FILENAME);
+    return;
+  }
+  list->saved = list->count;
+  list->appended = 0;
+  list->appendable = 1;
+}
+
+/*
+ * Persists the newest note by appending one record. The file is rewritten
+ * instead when it is missing or old-format, and once appended records
+ * outnumber the image, so loading never replays more than it reads in bulk.
+ */
+void appendToFile(NoteList *list)
+{
+  appendChange(list, RECORD_MAGIC, list->count - 1);
+}
+
+/*
+ * Appends one record for the note at pos: RECORD_MAGIC for a new note,
+ * UPDATE_MAGIC or DELETE_MAGIC for a change to an existing one, which
+ * carry pos in note.text. A delete record has no text.
+ */
+void appendChange(NoteList *list, const char *magic, int pos)
+{
+  if (!list->appendable || (list->appended >= COMPACT_MIN_RECORDS &&
+                            list->appended > list->saved))
+  {
+    saveToFile(list);
+    return;
+  }
+
+  const Note *n = noteAt(list, pos);
+  const char *text = noteTitle(list, n);
+  NoteRecord r;
+  memset(&r, 0, sizeof(r));
+  memcpy(r.magic, magic, 4);
+  r.note = *n;
+  r.note.text = memcmp(magic, RECORD_MAGIC, 4) == 0 ? 0 : (uint64_t)pos;
+  r.textSize = memcmp(magic, DELETE_MAGIC, 4) == 0
+                   ? 0
+                   : n->titleLen + n->categoryLen + n->contentLen + 3;
+  r.checksum = recordChecksum(&r, text);
+
+  FILE *fp = fopen(FILENAME, "ab");
+  int failed = !fp || fwrite(&r, sizeof(r), 1, fp) != 1 ||
+               fwrite(text, 1, r.textSize, fp) != r.textSize || syncFile(fp);
+  if ((fp && fclose(fp) != 0) || failed)
+  {
+    printf("Failed to save data!\n");
+    list->appendable = 0; /* the next add rewrites the file whole */
+    return;
+  }
+  list->appended++;
+}
+
+/* Version 1 files: an int count, then fixed 404-byte records */
+static void loadLegacy(NoteList *list, FILE *fp)
+{
+  int count = 0;
+  LegacyNote old;
+  rewind(fp);
+  if (fread(&count, sizeof(int), 1, fp) != 1)
+    return;
+  for (int i = 0; i < count && fread(&old, sizeof(old), 1, fp) == 1; i++)
+  {
+    old.title[MAX_TITLE_LEN - 1] = '\0';
+    old.category[MAX_CATEGORY_LEN - 1] = '\0';
+    old.content[MAX_CONTENT_LEN - 1] = '\0';
+    old.created_at[TIME_LEN - 1] = '\0';
+    appendNote(list, old.title, old.category, old.content, timestampParse(old.created_at, 0),
+               old.priority);
+  }
+}
+
+static Note noteFromV2(const NoteV2 *old)
+{
+  Note n;
+  char created_at[TIME_LEN];
+  memcpy(created_at, old->created_at, TIME_LEN);
+  created_at[TIME_LEN - 1] = '\0';
+  n.text = old->text;
+  n.titleLen = old->titleLen;
+  n.categoryLen = old->categoryLen;
+  n.contentLen = old->contentLen;
+  n.created = timestampParse(created_at, 0);
+  n.priority = old->priority;
+  n.flags = 0;
+  return n;
+}
+
+/* Fills notes[0..count) from the image, converting version 2 headers a chunk at a time */
+static int readHeaders(FILE *fp, Note *notes, uint32_t count, uint32_t version, StreamLoad *progress)
+{
+  if (version != 2)
+  {
+    if (streamRead(fp, notes, (uint64_t)sizeof(Note) * count, progress) != 0)
+      return -1;
+    for (uint32_t i = 0; version == 3 && i < count; i++)
+      notes[i].flags = 0; /* were padding before version 4 */
+    return 0;
+  }
+
+  NoteV2 *chunk = (NoteV2 *)malloc(sizeof(NoteV2) * CONVERT_CHUNK);
+  if (!chunk)
+    return -1;
+  for (uint32_t done = 0; done < count;)
+  {
+    uint32_t n = count - done < CONVERT_CHUNK ? count - done : CONVERT_CHUNK;
+    if (streamRead(fp, chunk, (uint64_t)sizeof(NoteV2) * n, progress) != 0)
+    {
+      free(chunk);
+      return -1;
+    }
+    for (uint32_t i = 0; i < n; i++)
+      notes[done + i] = noteFromV2(&chunk[i]);
+    done += n;
+  }
+  free(chunk);
+  return 0;
+}
+
+/* A note's three strings must sit inside the arena, NUL-terminated where expected */
+static int noteFits(const NoteList *list, const Note *n)
+{
+  uint64_t end = n->text + n->titleLen + n->categoryLen + (uint64_t)n->contentLen + 3;
+  return n->text < end && end <= list->arenaUsed &&
+         noteTitle(list, n)[n->titleLen] == '\0' &&
+         noteCategory(list, n)[n->categoryLen] == '\0' &&
+         noteContent(list, n)[n->contentLen] == '\0';
+}
+
+/*
+ * Replays the records appended after the image at offset base. Stops at
+ * the first short, unknown or corrupt one and cuts the file back to the
+ * end of the last good record.
+ */
+static void loadRecords(NoteList *list, FILE *fp, long base, uint32_t version)
+{
+  union
+  {
+    NoteRecord current;
+    NoteRecordV2 v2;
+  } r;
+  size_t recordSize = version == 2 ? sizeof(NoteRecordV2) : sizeof(NoteRecord);
+  char *text = NULL;
+  size_t size = 0;
+  long good = base;
+
+  /* magic and textSize lead both layouts; the checksum always ends them */
+  fseek(fp, base, SEEK_SET);
+  while (fread(&r, recordSize, 1, fp) == 1)
+  {
+    int isNew = memcmp(r.current.magic, RECORD_MAGIC, 4) == 0;
+    int isUpdate = version >= 4 && memcmp(r.current.magic, UPDATE_MAGIC, 4) == 0;
+    int isDelete = version >= 4 && memcmp(r.current.magic, DELETE_MAGIC, 4) == 0;
+    if (!isNew && !isUpdate && !isDelete)
+      break;
+    uint32_t textSize = r.current.textSize;
+    if (textSize > size)
+    {
+      char *temp = (char *)realloc(text, textSize);
+      if (temp == NULL)
+        break;
+      text = temp;
+      size = textSize;
+    }
+    uint64_t sum;
+    memcpy(&sum, (char *)&r + recordSize - sizeof(sum), sizeof(sum));
+    Note n = version == 2 ? noteFromV2(&r.v2.note) : r.current.note;
+    if (fread(text, 1, textSize, fp) != textSize ||
+        sum != checksum64(checksum64(14695981039346656037ull, &r, recordSize - sizeof(sum)),
+                          text, textSize) ||
+        (isDelete ? textSize != 0
+                  : (uint64_t)n.titleLen + n.categoryLen + n.contentLen + 3 != textSize))
+      break;
+
+    if (isDelete)
+      deleteNote(list, (int)n.text);
+    else
+    {
+      char *category = text + n.titleLen + 1;
+      char *content = category + n.categoryLen + 1;
+      text[n.titleLen] = category[n.categoryLen] = content[n.contentLen] = '\0';
+      if (isUpdate)
+        updateNote(list, (int)n.text, text, category, content, n.priority);
+      else
+        appendNote(list, text, category, content, n.created, n.priority);
+    }
+    list->appended++;
+    good = ftell(fp);
+  }
+  free(text);
+
+  fseek(fp, 0, SEEK_END);
+  if (ftell(fp) > good)
+  {
+    printf("Dropped a torn record at the end of %s\n", FILENAME);
+    if (truncate(FILENAME, good) != 0)
+      list->appendable = 0;
+  }
+}
+
+void loadFromFile(NoteList *list)
+{
+  FILE *fp = fopen(FILENAME, "rb");
+  if (!fp)
+  {
+    /* without notes.dat the archive is the live file, and changes rewrite it */
+    list->archived = loadArchive(list);
+    if (!list->archived)
+      printf("Failed to load file!\n");
+    return;
+  }
+
+  NoteFileHeader h;
+  if (fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, FILE_MAGIC, 4) != 0)
+  {
+    loadLegacy(list, fp);
+    fclose(fp);
+    return;
+  }
+
+  /* the header must describe an image that fits in the file before anything is allocated */
+  size_t noteSize = h.version == 2 ? sizeof(NoteV2) : sizeof(Note);
+  long fileSize = streamFileSize(fp, (long)sizeof(h));
+  uint64_t body = fileSize > (long)sizeof(h) ? (uint64_t)fileSize - sizeof(h) : 0;
+  if ((h.version < 2 || h.version > FILE_VERSION) || body / noteSize < h.count ||
+      body - (uint64_t)noteSize * h.count < h.arenaSize)
+  {
+    printf("%s is damaged, starting with no notes\n", FILENAME);
+    fclose(fp);
+    return;
+  }
+
+  /* headers and text go straight to their final place, read in chunks */
+  long base = (long)sizeof(h) + (long)noteSize * h.count + (long)h.arenaSize;
+  StreamLoad progress;
+  streamBegin(&progress, FILENAME, (uint64_t)base - sizeof(h));
+  while ((uint32_t)list->capacity < h.count)
+    resizeNoteList(list);
+  int failed = 0;
+  for (uint32_t done = 0; done < h.count && !failed; done += NOTE_PAGE)
+    failed = readHeaders(fp, list->pages[done >> NOTE_PAGE_BITS],
+                         h.count - done < NOTE_PAGE ? h.count - done : NOTE_PAGE, h.version,
+                         &progress) != 0;
+  char *arena = (char *)malloc(h.arenaSize > ARENA_INITIAL_SIZE ? h.arenaSize : ARENA_INITIAL_SIZE);
+  if (failed || !arena || streamRead(fp, arena, h.arenaSize, &progress) != 0)
+  {
+    printf("%s is damaged, starting with no notes\n", FILENAME);
+    free(arena);
+    fclose(fp);
+    return;
+  }
+  streamEnd(&progress);
+
+  /* the empty arena from initNoteList is in the published snapshot */
+  deferFree(list, list->arena);
+  list->arena = arena;
+  list->arenaUsed = h.arenaSize;
+  list->arenaCapacity = h.arenaSize > ARENA_INITIAL_SIZE ? h.arenaSize : ARENA_INITIAL_SIZE;
+
+  /* update and delete records name notes by position, so a damaged note keeps its place */
+  uint32_t skipped = 0;
+  for (; (uint32_t)list->count < h.count; list->count++)
+  {
+    Note *n = noteAt(list, list->count);
+    if (noteFits(list, n))
+    {
+      if (n->flags & NOTE_DELETED)
+        list->pageDeleted[list->count >> NOTE_PAGE_BITS]++;
+      indexNote(list, list->count);
+      continue;
+    }
+    notePlaceholder(list, list->count);
+    skipped++;
+  }
+  if (skipped)
+    printf("Skipped %u damaged note(s) in %s\n", skipped, FILENAME);
+  list->saved = list->count;
+  list->appendable = !skipped && h.version == FILE_VERSION;
+
+  loadRecords(list, fp, base, h.version);
+  fclose(fp);
+}
+
+void displayMenu()
+{
+  printf("\n1. Add Note");
+  printf("\n2. View All Notes");
+  printf("\n3. View Notes by Category");
+  printf("\n4. Exit");
+  printf("\n5. Search Notes");
+  printf("\n6. List Categories");
+  printf("\n7. Highest Priority Notes");
+  printf("\n8. Notes Between Dates");
+  printf("\n9. Latest Notes");
+  printf("\n10. Edit Note");
+  printf("\n11. Delete Note");
+  printf("\nEnter choice: ");
+}
+
+int getChoice()
+{
+  int ch;
+  while (scanf("%d", &ch) != 1)
+  {
+    printf("Enter a valid number between 1-11!\n");
+    clearBuffer();
+  }
+  clearBuffer();
+  return ch;
+}
+
+void clearBuffer()
+{
+  while (getchar() != '\n')
+    ;
+}
+
+/* Reads one whole line of any length into *buf (grown as needed), minus the newline */
+char *readLine(char **buf, size_t *size)
+{
+  ssize_t len = getline(buf, size, stdin);
+  if (len < 0)
+    return NULL;
+  (*buf)[strcspn(*buf, "\n")] = 0;
+  return *buf;
+}
+
+/* Reads a whole number from its own line; -1 when there is none */
+int readCount(const char *prompt)
+{
+  char *line = NULL;
+  size_t size = 0;
+  char *end;
+  printf("%s", prompt);
+  long n = readLine(&line, &size) ? strtol(line, &end, 10) : -1;
+  if (line == NULL || end == line || n < 0 || n > INT32_MAX)
+    n = -1;
+  free(line);
+  return (int)n;
+}
+
+void freeNoteList(NoteList *list)
+{
+  searchFree(&list->search);
+  categoryFree(&list->categories);
+  free(list->byTime.notes);
+  for (int b = 0; b < PRIORITY_BUCKETS; b++)
+    free(list->byPriority[b].notes);
+  /* no reader may still be inside */
+  EpochDomain *d = &list->epochs;
+  for (int i = 0; i < d->pendingCount; i++)
+    free(d->pending[i]);
+  for (int i = 0; i < d->retiredCount; i++)
+    free(d->retired[i].memory);
+  free(d->pending);
+  free(d->retired);
+  free(atomic_load(&list->current));
+  for (int p = 0; p < list->pageCount; p++)
+    free(list->pages[p]);
+  free(list->pages);
+  free(list->pageCopied);
+  free(list->pageDeleted);
+  free(list->arena);
+}
+
+/* ================= FULL-TEXT SEARCH ================= */
+
+static void *checkedRealloc(void *p, size_t size)
+{
+  void *temp = realloc(p, size);
+  if (temp == NULL)
+  {
+    printf("Memory allocation failed!\n");
+    exit(1);
+  }
+  return temp;
+}
+
+static void slotsInit(SearchIndex *idx, int capacity)
+{
+  idx->capacity = capacity;
+  idx->used = 0;
+  idx->slots = (Posting *)checkedRealloc(NULL, sizeof(Posting) * capacity);
+  for (int i = 0; i < capacity; i++)
+    idx->slots[i].term = UINT32_MAX;
+}
+
+void searchInit(SearchIndex *idx)
+{
+  memset(idx, 0, sizeof(*idx));
+  slotsInit(idx, TERMS_INITIAL_SLOTS);
+}
+
+void searchFree(SearchIndex *idx)
+{
+  for (int i = 0; i < idx->capacity; i++)
+    if (idx->slots[i].term != UINT32_MAX)
+      free(idx->slots[i].bytes);
+  free(idx->slots);
+  free(idx->terms);
+  free(idx->length);
+  free(idx->noteOf);
+  free(idx->docOf);
+  free(idx->scores);
+  free(idx->touched);
+  free(idx->counts);
+  free(idx->countSlots);
+}
+
+/* Next lower-cased run of letters and digits after *text, or 0 at the end */
+static int nextToken(const char **text, char *term)
+{
+  const char *p = *text;
+  while (*p && !isalnum((unsigned char)*p))
+    p++;
+  int len = 0;
+  for (; isalnum((unsigned char)*p); p++)
+    if (len < TERM_MAX)
+      term[len++] = (char)tolower((unsigned char)*p);
+  term[len] = '\0';
+  *text = p;
+  return len;
+}
+
+static uint32_t termHash(const char *term)
+{
+  uint32_t h = 2166136261u;
+  for (; *term; term++)
+  {
+    h ^= (unsigned char)*term;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static Posting *findPosting(const SearchIndex *idx, const char *term, uint32_t hash)
+{
+  uint32_t mask = (uint32_t)idx->capacity - 1;
+  for (uint32_t s = hash & mask; idx->slots[s].term != UINT32_MAX; s = (s + 1) & mask)
+    if (idx->slots[s].hash == hash && strcmp(idx->terms + idx->slots[s].term, term) == 0)
+      return &idx->slots[s];
+  return NULL;
+}
+
+/* Existing posting for term, or a new empty one */
+static Posting *postingFor(SearchIndex *idx, const char *term)
+{
+  uint32_t hash = termHash(term);
+  Posting *p = findPosting(idx, term, hash);
+  if (p)
+    return p;
+
+  if ((idx->used + 1) * 2 > idx->capacity)
+  {
+    Posting *old = idx->slots;
+    int oldCapacity = idx->capacity;
+    slotsInit(idx, oldCapacity * 2);
+    for (int i = 0; i < oldCapacity; i++)
+    {
+      if (old[i].term == UINT32_MAX)
+        continue;
+      uint32_t s = old[i].hash & (uint32_t)(idx->capacity - 1);
+      while (idx->slots[s].term != UINT32_MAX)
+        s = (s + 1) & (uint32_t)(idx->capacity - 1);
+      idx->slots[s] = old[i];
+      idx->used++;
+    }
+    free(old);
+  }
+
+  size_t len = strlen(term) + 1;
+  if (idx->termsUsed + len > idx->termsCapacity)
+  {
+    idx->termsCapacity = idx->termsCapacity ? idx->termsCapacity * 2 : 4096;
+    idx->terms = (char *)checkedRealloc(idx->terms, idx->termsCapacity);
+  }
+  memcpy(idx->terms + idx->termsUsed, term, len);
+
+  uint32_t s = hash & (uint32_t)(idx->capacity - 1);
+  while (idx->slots[s].term != UINT32_MAX)
+    s = (s + 1) & (uint32_t)(idx->capacity - 1);
+  p = &idx->slots[s];
+  memset(p, 0, sizeof(*p));
+  p->hash = hash;
+  p->term = (uint32_t)idx->termsUsed;
+  idx->termsUsed += len;
+  idx->used++;
+  return p;
+}
+
+static void putVarint(Posting *p, uint32_t v)
+{
+  if (p->used + 5 > p->capacity)
+  {
+    p->capacity = p->capacity ? p->capacity * 2 : 8;
+    p->bytes = (uint8_t *)checkedRealloc(p->bytes, p->capacity);
+  }
+  while (v >= 0x80)
+  {
+    p->bytes[p->used++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p->bytes[p->used++] = (uint8_t)v;
+}
+
+static uint32_t getVarint(const uint8_t **at)
+{
+  const uint8_t *p = *at;
+  uint32_t v = *p & 0x7f;
+  for (int shift = 7; *p++ & 0x80; shift += 7)
+    v |= (uint32_t)(*p & 0x7f) << shift;
+  *at = p;
+  return v;
+}
+
+/* Slot in countSlots holding term, or the free slot where it would go */
+static int *countSlot(const SearchIndex *idx, const char *term, uint32_t hash)
+{
+  uint32_t mask = (uint32_t)idx->countCapacity * 2 - 1;
+  uint32_t s = hash & mask;
+  for (int i; (i = idx->countSlots[s]) != -1; s = (s + 1) & mask)
+    if (idx->counts[i].hash == hash && strcmp(idx->counts[i].term, term) == 0)
+      break;
+  return &idx->countSlots[s];
+}
+
+/* Adds the tokens of text to the n distinct terms counted so far; returns their weight */
+static int countTerms(SearchIndex *idx, const char *text, int weight, int *n)
+{
+  char term[TERM_MAX + 1];
+  int total = 0;
+  while (nextToken(&text, term) > 0)
+  {
+    total += weight;
+    uint32_t hash = termHash(term);
+    if (*n == idx->countCapacity)
+    {
+      idx->countCapacity = idx->countCapacity ? idx->countCapacity * 2 : 64;
+      idx->counts = (TermCount *)checkedRealloc(idx->counts, sizeof(TermCount) * idx->countCapacity);
+      idx->countSlots = (int *)checkedRealloc(idx->countSlots,
+                                              sizeof(int) * idx->countCapacity * 2);
+      memset(idx->countSlots, 0xff, sizeof(int) * idx->countCapacity * 2);
+      for (int i = 0; i < *n; i++)
+        *countSlot(idx, idx->counts[i].term, idx->counts[i].hash) = i;
+    }
+    int *slot = countSlot(idx, term, hash);
+    if (*slot == -1)
+    {
+      *slot = (*n)++;
+      strcpy(idx->counts[*slot].term, term);
+      idx->counts[*slot].hash = hash;
+      idx->counts[*slot].tf = 0;
+    }
+    idx->counts[*slot].tf += weight;
+  }
+  return total;
+}
+
+/* Frees the slots of the n counted terms; last in first, so every probe run stays whole */
+static void clearCounts(SearchIndex *idx, int n)
+{
+  for (int i = n - 1; i >= 0; i--)
+    *countSlot(idx, idx->counts[i].term, idx->counts[i].hash) = -1;
+}
+
+/* Indexes note number note under a fresh doc */
+void searchAdd(SearchIndex *idx, int note, const char *title, const char *content)
+{
+  int n = 0;
+  int length = countTerms(idx, title, TITLE_WEIGHT, &n) + countTerms(idx, content, 1, &n);
+  clearCounts(idx, n);
+  const TermCount *counts = idx->counts;
+
+  int doc = idx->docs++;
+  if (doc >= idx->docCapacity)
+  {
+    int capacity = idx->docCapacity ? idx->docCapacity * 2 : 1024;
+    idx->length = (uint16_t *)checkedRealloc(idx->length, sizeof(uint16_t) * capacity);
+    idx->noteOf = (int *)checkedRealloc(idx->noteOf, sizeof(int) * capacity);
+    idx->scores = (float *)checkedRealloc(idx->scores, sizeof(float) * capacity);
+    idx->touched = (int *)checkedRealloc(idx->touched, sizeof(int) * capacity);
+    memset(idx->scores + idx->docCapacity, 0, sizeof(float) * (capacity - idx->docCapacity));
+    idx->docCapacity = capacity;
+  }
+  if (note >= idx->noteCapacity)
+  {
+    int capacity = idx->noteCapacity ? idx->noteCapacity : 1024;
+    while (capacity <= note)
+      capacity *= 2;
+    idx->docOf = (int *)checkedRealloc(idx->docOf, sizeof(int) * capacity);
+    memset(idx->docOf + idx->noteCapacity, 0xff, sizeof(int) * (capacity - idx->noteCapacity));
+    idx->noteCapacity = capacity;
+  }
+  idx->length[doc] = (uint16_t)(length > UINT16_MAX ? UINT16_MAX : length);
+  idx->noteOf[doc] = note;
+  idx->docOf[note] = doc;
+  idx->totalLength += idx->length[doc];
+  idx->live++;
+
+  for (int i = 0; i < n; i++)
+  {
+    Posting *p = postingFor(idx, counts[i].term);
+    putVarint(p, (uint32_t)doc - p->last);
+    putVarint(p, (uint32_t)counts[i].tf);
+    p->last = (uint32_t)doc;
+    p->docs++;
+  }
+}
+
+/*
+ * Tombstones the doc of note number note, whose text is still title and
+ * content. Its pairs stay in the postings until the index is rebuilt.
+ */
+void searchRemove(SearchIndex *idx, int note, const char *title, const char *content)
+{
+  int doc = note < idx->noteCapacity ? idx->docOf[note] : -1;
+  if (doc < 0)
+    return;
+  int n = 0;
+  countTerms(idx, title, TITLE_WEIGHT, &n);
+  countTerms(idx, content, 1, &n);
+  clearCounts(idx, n);
+  for (int i = 0; i < n; i++)
+  {
+    Posting *p = findPosting(idx, idx->counts[i].term, idx->counts[i].hash);
+    if (p)
+      p->docs--;
+  }
+  idx->totalLength -= idx->length[doc];
+  idx->noteOf[doc] = -1;
+  idx->docOf[note] = -1;
+  idx->live--;
+}
+
+/* BM25 over the query's distinct terms; fills hits best first, returns how many */
+int searchQuery(SearchIndex *idx, const char *query, SearchHit *hits, int k)
+{
+  char seen[QUERY_LEN / 2][TERM_MAX + 1];
+  char term[TERM_MAX + 1];
+  int terms = 0, touched = 0;
+  double avgLength = idx->live ? (double)idx->totalLength / idx->live : 1.0;
+
+  while (terms < QUERY_LEN / 2 && nextToken(&query, term) > 0)
+  {
+    int dup = 0;
+    for (int i = 0; i < terms && !dup; i++)
+      dup = strcmp(seen[i], term) == 0;
+    if (dup)
+      continue;
+    strcpy(seen[terms++], term);
+
+    const Posting *p = findPosting(idx, term, termHash(term));
+    if (!p)
+      continue;
+    float idf = (float)log(1.0 + (idx->live - p->docs + 0.5) / (p->docs + 0.5));
+    const uint8_t *at = p->bytes, *end = p->bytes + p->used;
+    uint32_t doc = 0;
+    while (at < end)
+    {
+      doc += getVarint(&at);
+      float tf = (float)getVarint(&at);
+      if (idx->noteOf[doc] < 0)
+        continue;
+      float norm = (float)(BM25_K1 * (1 - BM25_B + BM25_B * idx->length[doc] / avgLength));
+      if (idx->scores[doc] == 0)
+        idx->touched[touched++] = (int)doc;
+      idx->scores[doc] += idf * tf * (float)(BM25_K1 + 1) / (tf + norm);
+    }
+  }
+
+  /* keep the best k, then leave the scratch array zeroed for the next query */
+  int n = 0;
+  for (int i = 0; i < touched; i++)
+  {
+    int doc = idx->touched[i];
+    int note = idx->noteOf[doc];
+    float score = idx->scores[doc];
+    idx->scores[doc] = 0;
+    /* docs do not come in note order, so ties are settled by note here */
+    if (n == k && (score < hits[k - 1].score ||
+                   (score == hits[k - 1].score && note > hits[k - 1].note)))
+      continue;
+    int j = n < k ? n++ : k - 1;
+    for (; j > 0 && (hits[j - 1].score < score ||
+                     (hits[j - 1].score == score && hits[j - 1].note > note));
+         j--)
+      hits[j] = hits[j - 1];
+    hits[j].note = note;
+    hits[j].score = score;
+  }
+  return n;
+}
+
+/* ================= TIME AND PRIORITY ORDER ================= */
+
+static void refsInsert(NoteRefs *refs, int at, int note)
+{
+  if (refs->count == refs->capacity)
+  {
+    refs->capacity = refs->capacity ? refs->capacity * 2 : 64;
+    refs->notes = (int *)checkedRealloc(refs->notes, sizeof(int) * refs->capacity);
+  }
+  memmove(refs->notes + at + 1, refs->notes + at, sizeof(int) * (refs->count - at));
+  refs->notes[at] = note;
+  refs->count++;
+}
+
+static int priorityBucket(int priority)
+{
+  return priority >= 1 && priority < PRIORITY_BUCKETS ? priority - 1 : PRIORITY_BUCKETS - 1;
+}
+
+/* First index in ascending refs holding note or more */
+static int refsLowerBound(const NoteRefs *refs, int note)
+{
+  int lo = 0, hi = refs->count;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    if (refs->notes[mid] < note)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static void refsRemove(NoteRefs *refs, int at)
+{
+  memmove(refs->notes + at, refs->notes + at + 1, sizeof(int) * (refs->count - at - 1));
+  refs->count--;
+}
+
+/* First index in byTime at or after (when, pos); ties on time keep position order */
+static int timeLowerBoundAt(const NoteList *list, int64_t when, int pos)
+{
+  int lo = 0, hi = list->byTime.count;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    int at = list->byTime.notes[mid];
+    int64_t created = noteAt(list, at)->created;
+    if (created < when || (created == when && at < pos))
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* First position in byTime whose note was created at or after when */
+static int timeLowerBound(const NoteList *list, int64_t when)
+{
+  return timeLowerBoundAt(list, when, INT32_MIN);
+}
+
+/*
+ * Files note pos in its category and the time and priority indexes.
+ * Notes nearly always arrive in time order, so the time index is normally
+ * appended to; an older timestamp or an edited note is placed by binary
+ * search instead. Deleted notes stay out of every index.
+ */
+void indexNote(NoteList *list, int pos)
+{
+  const Note *n = noteAt(list, pos);
+  if (n->flags & NOTE_DELETED)
+    return;
+  categoryAdd(&list->categories, noteCategory(list, n), pos);
+
+  NoteRefs *t = &list->byTime;
+  int last = t->count > 0 ? t->notes[t->count - 1] : -1;
+  int at = last >= 0 && (noteAt(list, last)->created > n->created ||
+                         (noteAt(list, last)->created == n->created && last > pos))
+               ? timeLowerBoundAt(list, n->created, pos)
+               : t->count;
+  refsInsert(t, at, pos);
+
+  NoteRefs *b = &list->byPriority[priorityBucket(n->priority)];
+  refsInsert(b, b->count > 0 && b->notes[b->count - 1] > pos ? refsLowerBound(b, pos) : b->count,
+             pos);
+}
+
+/* Takes note pos back out of the indexes, before it is edited or deleted */
+void unindexNote(NoteList *list, int pos)
+{
+  const Note *n = noteAt(list, pos);
+  categoryRemove(&list->categories, noteCategory(list, n), pos);
+
+  int at = timeLowerBoundAt(list, n->created, pos);
+  if (at < list->byTime.count && list->byTime.notes[at] == pos)
+    refsRemove(&list->byTime, at);
+
+  NoteRefs *b = &list->byPriority[priorityBucket(n->priority)];
+  at = refsLowerBound(b, pos);
+  if (at < b->count && b->notes[at] == pos)
+    refsRemove(b, at);
+}
+
+/* ================= EDITING AND SNAPSHOTS ================= */
+
+/*
+ * One writer at a time changes a NoteList; any number of reader threads
+ * may look at it through snapshotEnter/snapshotLeave without locking.
+ * Writers never touch memory a published snapshot can see: new notes and
+ * text go past the snapshot's end, a changed header goes into a fresh
+ * copy of its page, and outgrown buffers are retired, not freed.
+ * Changes become visible at the next publishSnapshot.
+ */
+
+/*
+ * Makes the page holding note pos private to the writer before the header
+ * is changed in place; returns the header. A published snapshot keeps the
+ * old page and page table.
+ */
+static Note *unshareNote(NoteList *list, int pos)
+{
+  int p = pos >> NOTE_PAGE_BITS;
+  if (list->pageCopied[p] == list->snapshots)
+    return noteAt(list, pos);
+  if (list->tableCopied != list->snapshots)
+  {
+    list->pages = (Note **)replaceBuffer(list, list->pages, sizeof(Note *) * list->pageCount,
+                                         sizeof(Note *) * list->pageCapacity);
+    list->tableCopied = list->snapshots;
+  }
+  int used = list->count - (p << NOTE_PAGE_BITS);
+  list->pages[p] = (Note *)replaceBuffer(list, list->pages[p],
+                                         sizeof(Note) * (used < NOTE_PAGE ? used : NOTE_PAGE),
+                                         sizeof(Note) * NOTE_PAGE);
+  list->pageCopied[p] = list->snapshots;
+  return noteAt(list, pos);
+}
+
+/*
+ * Takes note pos out of the search index before its text changes. Once
+ * tombstoned docs outnumber live ones the index is dropped instead, to be
+ * rebuilt compactly on the next search.
+ */
+static void unsearchNote(NoteList *list, int pos)
+{
+  if (!list->searchReady)
+    return;
+  SearchIndex *idx = &list->search;
+  const Note *n = noteAt(list, pos);
+  searchRemove(idx, pos, noteTitle(list, n), noteContent(list, n));
+  int dead = idx->docs - idx->live;
+  if (dead >= SEARCH_REBUILD_MIN && dead > idx->live)
+  {
+    searchFree(idx);
+    searchInit(idx);
+    list->searchReady = 0;
+  }
+}
+
+/* Replaces the text and priority of note pos, keeping its position and time; 0 on success */
+int updateNote(NoteList *list, int pos, const char *title, const char *category,
+               const char *content, int priority)
+{
+  if (livePosition(list, pos + 1) < 0)
+    return -1;
+  unindexNote(list, pos);
+  unsearchNote(list, pos);
+
+  size_t titleLen = strlen(title), categoryLen = strlen(category);
+  titleLen = titleLen > UINT16_MAX ? UINT16_MAX : titleLen;
+  categoryLen = categoryLen > UINT16_MAX ? UINT16_MAX : categoryLen;
+  uint32_t contentLen = (uint32_t)strlen(content);
+  uint64_t text = arenaPut(list, title, titleLen);
+  arenaPut(list, category, categoryLen);
+  arenaPut(list, content, contentLen);
+
+  Note *n = unshareNote(list, pos);
+  n->text = text;
+  n->titleLen = (uint16_t)titleLen;
+  n->categoryLen = (uint16_t)categoryLen;
+  n->contentLen = contentLen;
+  n->priority = priority;
+  indexNote(list, pos);
+  if (list->searchReady)
+    searchAdd(&list->search, pos, noteTitle(list, n), noteContent(list, n));
+  return 0;
+}
+
+/* Marks note pos deleted; later notes keep their numbers. 0 on success */
+int deleteNote(NoteList *list, int pos)
+{
+  if (livePosition(list, pos + 1) < 0)
+    return -1;
+  unindexNote(list, pos);
+  unsearchNote(list, pos);
+  unshareNote(list, pos)->flags |= NOTE_DELETED;
+  list->pageDeleted[pos >> NOTE_PAGE_BITS]++;
+  return 0;
+}
+
+static void retire(EpochDomain *d, void *memory, uint64_t epoch)
+{
+  if (d->retiredCount == d->retiredCapacity)
+  {
+    d->retiredCapacity = d->retiredCapacity ? d->retiredCapacity * 2 : 16;
+    d->retired = (Retired *)checkedRealloc(d->retired, sizeof(Retired) * d->retiredCapacity);
+  }
+  d->retired[d->retiredCount].memory = memory;
+  d->retired[d->retiredCount].epoch = epoch;
+  d->retiredCount++;
+}
+
+/* Frees everything retired before the oldest epoch a reader is still in */
+static void reclaim(EpochDomain *d)
+{
+  uint64_t oldest = UINT64_MAX;
+  int readers = atomic_load(&d->readers);
+  for (int i = 0; i < readers && i < EPOCH_MAX_READERS; i++)
+  {
+    uint64_t e = atomic_load(&d->slots[i].epoch);
+    if (e != 0 && e < oldest)
+      oldest = e;
+  }
+  int kept = 0;
+  for (int i = 0; i < d->retiredCount; i++)
+  {
+    if (d->retired[i].epoch < oldest)
+      free(d->retired[i].memory);
+    else
+      d->retired[kept++] = d->retired[i];
+  }
+  d->retiredCount = kept;
+}
+
+/* Makes the writer's changes visible to readers entering from now on */
+void publishSnapshot(NoteList *list)
+{
+  EpochDomain *d = &list->epochs;
+  NoteSnapshot *s = (NoteSnapshot *)checkedRealloc(NULL, sizeof(NoteSnapshot));
+  s->pages = (const Note *const *)list->pages;
+  s->count = list->count;
+  s->arena = list->arena;
+  NoteSnapshot *old = atomic_exchange(&list->current, s);
+  list->snapshots++; /* every page and the table are now shared */
+
+  /* a reader still holding old entered at this epoch or before */
+  uint64_t epoch = atomic_load(&d->global);
+  if (old)
+    retire(d, old, epoch);
+  for (int i = 0; i < d->pendingCount; i++)
+    retire(d, d->pending[i], epoch);
+  d->pendingCount = 0;
+  atomic_fetch_add(&d->global, 1);
+  reclaim(d);
+}
+
+/* Registers the calling reader thread; returns its slot, or -1 when all are taken */
+int snapshotReader(NoteList *list)
+{
+  int slot = atomic_fetch_add(&list->epochs.readers, 1);
+  return slot < EPOCH_MAX_READERS ? slot : -1;
+}
+
+/* The current snapshot, valid until the matching snapshotLeave */
+const NoteSnapshot *snapshotEnter(NoteList *list, int reader)
+{
+  EpochDomain *d = &list->epochs;
+  atomic_store(&d->slots[reader].epoch, atomic_load(&d->global));
+  return atomic_load(&list->current);
+}
+
+void snapshotLeave(NoteList *list, int reader)
+{
+  atomic_store_explicit(&list->epochs.slots[reader].epoch, 0, memory_order_release);
+}
+
+const Note *snapshotNote(const NoteSnapshot *s, int pos)
+{
+  return &s->pages[pos >> NOTE_PAGE_BITS][pos & (NOTE_PAGE - 1)];
+}
+
+typedef struct
+{
+  NoteList *list;
+  int reader;
+  _Atomic int *stop;
+  uint64_t reads;
+  uint64_t torn; /* titles not ending where their header says: must stay 0 */
+} BenchReader;
+
+static double benchNow(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint64_t benchRandom(uint64_t *x)
+{
+  *x ^= *x << 13;
+  *x ^= *x >> 7;
+  *x ^= *x << 17;
+  return *x;
+}
+
+/* Looks up random notes, BENCH_BATCH per snapshot, until told to stop */
+static void *benchReaderThread(void *arg)
+{
+  BenchReader *b = (BenchReader *)arg;
+  uint64_t x = 0x9E3779B97F4A7C15ull * (uint64_t)(b->reader + 1);
+  while (!atomic_load_explicit(b->stop, memory_order_relaxed))
+  {
+    const NoteSnapshot *s = snapshotEnter(b->list, b->reader);
+    for (int i = 0; i < BENCH_BATCH && s->count > 0; i++)
+    {
+      const Note *n = snapshotNote(s, (int)(benchRandom(&x) % (uint64_t)s->count));
+      b->torn += s->arena[n->text + n->titleLen] != '\0';
+    }
+    snapshotLeave(b->list, b->reader);
+    b->reads += BENCH_BATCH;
+  }
+  return NULL;
+}
+
+/*
+ * Runs readers for seconds; with a writer the calling thread meanwhile
+ * edits random notes, adding or deleting one now and then, and publishes
+ * after every change. Reports reads per second and writes per second.
+ */
+static void benchPhase(NoteList *list, BenchReader *readers, int count, int seconds,
+                       int withWriter)
+{
+  _Atomic int stop = 0;
+  pthread_t threads[EPOCH_MAX_READERS];
+  int started = 0;
+  for (; started < count; started++)
+  {
+    readers[started].stop = &stop;
+    readers[started].reads = 0;
+    readers[started].torn = 0;
+    if (pthread_create(&threads[started], NULL, benchReaderThread, &readers[started]) != 0)
+      break;
+  }
+
+  double start = benchNow();
+  uint64_t writes = 0, x = 0x2545F4914F6CDD1Dull;
+  if (withWriter)
+  {
+    while (benchNow() - start < seconds)
+    {
+      int pos = (int)(benchRandom(&x) % (uint64_t)list->count);
+      const Note *n = noteAt(list, pos);
+      if (writes % 16 == 15)
+        appendNote(list, noteTitle(list, n), noteCategory(list, n), noteContent(list, n),
+                   timestampNow(), n->priority);
+      else if (writes % 16 == 7)
+        deleteNote(list, pos);
+      else
+        updateNote(list, pos, noteTitle(list, n), noteCategory(list, n), noteContent(list, n),
+                   (int)(benchRandom(&x) % 3) + 1);
+      publishSnapshot(list);
+      writes++;
+    }
+  }
+  else
+  {
+    while (benchNow() - start < seconds)
+      usleep(10000);
+  }
+  atomic_store(&stop, 1);
+
+  uint64_t reads = 0, torn = 0;
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+    reads += readers[i].reads;
+    torn += readers[i].torn;
+  }
+  double elapsed = benchNow() - start;
+  printf("%-14s %9.2f M reads/s", withWriter ? "with writer:" : "readers only:",
+         reads / elapsed / 1e6);
+  if (withWriter)
+    printf(", %.0f writes/s, %d buffer(s) awaiting reclaim", writes / elapsed,
+           list->epochs.retiredCount);
+  printf(", %llu torn\n", (unsigned long long)torn);
+}
+
+/* Read throughput of snapshot readers, alone and next to a busy writer */
+void runBenchmark(NoteList *list, int readers, int seconds)
+{
+  if (list->count == 0)
+  {
+    printf("No notes to benchmark.\n");
+    return;
+  }
+  if (readers < 1 || readers > EPOCH_MAX_READERS)
+    readers = BENCH_READERS;
+  if (seconds < 1)
+    seconds = BENCH_SECONDS;
+
+  BenchReader *r = (BenchReader *)checkedRealloc(NULL, sizeof(BenchReader) * readers);
+  for (int i = 0; i < readers; i++)
+  {
+    r[i].list = list;
+    r[i].reader = snapshotReader(list);
+  }
+  printf("%d notes, %d reader thread(s), %d s per run\n", list->count, readers, seconds);
+  benchPhase(list, r, readers, seconds, 0);
+  benchPhase(list, r, readers, seconds, 1);
+  free(r);
+}
+
+/* ================= RENDERING ================= */
+
+/* Output gathered in one reusable buffer and handed to write() when full */
+typedef struct
+{
+  char *data;
+  size_t used;
+  size_t capacity;
+  int fd;
+  int failed;
+} OutBuffer;
+
+static void outFlush(OutBuffer *out)
+{
+  size_t done = 0;
+  while (done < out->used && !out->failed)
+  {
+    ssize_t n = write(out->fd, out->data + done, out->used - done);
+    if (n <= 0)
+      out->failed = 1;
+    else
+      done += (size_t)n;
+  }
+  out->used = 0;
+}
+
+static void outBytes(OutBuffer *out, const char *text, size_t len)
+{
+  while (len > out->capacity - out->used)
+  {
+    size_t room = out->capacity - out->used;
+    memcpy(out->data + out->used, text, room);
+    out->used += room;
+    text += room;
+    len -= room;
+    outFlush(out);
+  }
+  memcpy(out->data + out->used, text, len);
+  out->used += len;
+}
+
+#define outLiteral(out, text) outBytes(out, text, sizeof(text) - 1)
+
+static void outInt(OutBuffer *out, long value)
+{
+  char digits[24];
+  int n = sizeof(digits);
+  unsigned long v = value < 0 ? 0ul - (unsigned long)value : (unsigned long)value;
+  do
+  {
+    digits[--n] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  if (value < 0)
+    digits[--n] = '-';
+  outBytes(out, digits + n, sizeof(digits) - n);
+}
+
+/*
+ * Writes the live notes from the offset-th to fd in the View All Notes
+ * layout, at most limit of them (all when limit is negative).
+ */
+void renderNotes(const NoteList *list, long offset, long limit, int fd)
+{
+  OutBuffer out = {(char *)checkedRealloc(NULL, RENDER_BUFFER), 0, RENDER_BUFFER, fd, 0};
+  char created_at[TIMESTAMP_LEN];
+  long skipped = 0, shown = 0;
+
+  fflush(stdout); /* keep earlier printf output ahead of ours */
+
+  /* pages wholly before the offset are skipped by their live counts */
+  int i = 0;
+  while (i < list->count)
+  {
+    int inPage = list->count - i < NOTE_PAGE ? list->count - i : NOTE_PAGE;
+    long live = inPage - list->pageDeleted[i >> NOTE_PAGE_BITS];
+    if (skipped + live > offset)
+      break;
+    skipped += live;
+    i += NOTE_PAGE;
+  }
+  for (; i < list->count && (limit < 0 || shown < limit) && !out.failed; i++)
+  {
+    const Note *n = noteAt(list, i);
+    if (n->flags & NOTE_DELETED)
+      continue;
+    if (skipped < offset)
+    {
+      skipped++;
+      continue;
+    }
+    if (shown == 0)
+      outLiteral(&out, "\n=== ALL NOTES ===\n");
+    timestampText(n->created, created_at);
+    outLiteral(&out, "\n[");
+    outInt(&out, i + 1);
+    outLiteral(&out, "] ");
+    outBytes(&out, noteTitle(list, n), n->titleLen);
+    outLiteral(&out, " (");
+    outBytes(&out, noteCategory(list, n), n->categoryLen);
+    outLiteral(&out, ")\nPriority: ");
+    outInt(&out, n->priority);
+    outLiteral(&out, "\nCreated: ");
+    outBytes(&out, created_at, strlen(created_at));
+    outLiteral(&out, "\nContent: ");
+    outBytes(&out, noteContent(list, n), n->contentLen);
+    outLiteral(&out, "\n");
+    shown++;
+  }
+  if (shown == 0)
+    outLiteral(&out, "\nNo notes available.\n");
+  outFlush(&out);
+  free(out.data);
+}
+
+/* The former printf-per-field layout, kept as the baseline for bench-render */
+static void printNotes(const NoteList *list, FILE *fp)
+{
+  fprintf(fp, "\n=== ALL NOTES ===\n");
+  for (int i = 0; i < list->count; i++)
+  {
+    const Note *n = noteAt(list, i);
+    if (n->flags & NOTE_DELETED)
+      continue;
+    char created_at[TIMESTAMP_LEN];
+    timestampText(n->created, created_at);
+    fprintf(fp, "\n[%d] %s (%s)\n", i + 1, noteTitle(list, n), noteCategory(list, n));
+    fprintf(fp, "Priority: %d\n", n->priority);
+    fprintf(fp, "Created: %s\n", created_at);
+    fprintf(fp, "Content: %s\n", noteContent(list, n));
+  }
+}
+
+/* Times both ways of dumping every note into /dev/null */
+void runRenderBenchmark(const NoteList *list)
+{
+  FILE *sink = fopen("/dev/null", "w");
+  if (!sink)
+  {
+    printf("Cannot open /dev/null\n");
+    return;
+  }
+  double start = benchNow();
+  printNotes(list, sink);
+  fflush(sink);
+  double before = benchNow() - start;
+
+  start = benchNow();
+  renderNotes(list, 0, -1, fileno(sink));
+  double after = benchNow() - start;
+  fclose(sink);
+
+  printf("%d notes\n", list->count);
+  printf("printf per field: %7.3f s (%8.0f notes/s)\n", before, list->count / before);
+  printf("buffered render:  %7.3f s (%8.0f notes/s)\n", after, list->count / after);
+}
+
+static void showNoteLine(const NoteList *list, int pos)
+{
+  const Note *n = noteAt(list, pos);
+  char created_at[TIMESTAMP_LEN];
+  timestampText(n->created, created_at);
+  printf("\n[%d] %s (%s) - %s, priority %d\n", pos + 1, noteTitle(list, n),
+         noteCategory(list, n), created_at, n->priority);
+  printf("%s\n", noteContent(list, n));
+}
+
+/* Highest priority first, newest first within a priority */
+void showTopPriority(NoteList *list)
+{
+  int want = readCount("\nHow many notes: ");
+  int shown = 0;
+  for (int b = 0; b < PRIORITY_BUCKETS && shown < want; b++)
+    for (int i = list->byPriority[b].count - 1; i >= 0 && shown < want; i--, shown++)
+      showNoteLine(list, list->byPriority[b].notes[i]);
+  if (shown == 0)
+    printf("\nNo notes available.\n");
+}
+
+void showBetween(NoteList *list)
+{
+  char *from = NULL, *to = NULL;
+  size_t fromSize = 0, toSize = 0;
+  printf("\nFrom (YYYY-MM-DD [HH:MM:SS]): ");
+  readLine(&from, &fromSize);
+  printf("To   (YYYY-MM-DD [HH:MM:SS]): ");
+  readLine(&to, &toSize);
+  int64_t start = from ? timestampParse(from, 0) : -1;
+  int64_t end = to ? timestampParse(to, 1) : -1;
+  free(from);
+  free(to);
+  if (start == -1 || end == -1)
+  {
+    printf("\nDates must look like 2026-01-14 or 2026-01-14 09:55:01\n");
+    return;
+  }
+
+  int shown = 0;
+  for (int i = timeLowerBound(list, start);
+       i < list->byTime.count && noteAt(list, list->byTime.notes[i])->created <= end; i++, shown++)
+    showNoteLine(list, list->byTime.notes[i]);
+  if (shown == 0)
+    printf("\nNo notes in that period.\n");
+}
+
+void showLatest(NoteList *list)
+{
+  int want = readCount("\nHow many notes: ");
+  int shown = 0;
+  for (int i = list->byTime.count - 1; i >= 0 && shown < want; i--, shown++)
+    showNoteLine(list, list->byTime.notes[i]);
+  if (shown == 0)
+    printf("\nNo notes available.\n");
+}
+
+/* ================= CATEGORY INDEX ================= */
+
+void categoryInit(CategoryIndex *idx)
+{
+  idx->slotCapacity = CATEGORY_INITIAL_SLOTS;
+  idx->slots = (CategorySlot *)checkedRealloc(NULL, sizeof(CategorySlot) * idx->slotCapacity);
+  for (int i = 0; i < idx->slotCapacity; i++)
+    idx->slots[i].id = -1;
+  idx->list = NULL;
+  idx->count = 0;
+  idx->capacity = 0;
+}
+
+void categoryFree(CategoryIndex *idx)
+{
+  for (int i = 0; i < idx->count; i++)
+  {
+    free(idx->list[i].name);
+    free(idx->list[i].notes);
+  }
+  free(idx->list);
+  free(idx->slots);
+}
+
+static int categorySlot(const CategoryIndex *idx, const char *name, uint32_t hash)
+{
+  uint32_t mask = (uint32_t)idx->slotCapacity - 1;
+  uint32_t s = hash & mask;
+  while (idx->slots[s].id != -1 &&
+         (idx->slots[s].hash != hash || strcmp(idx->list[idx->slots[s].id].name, name) != 0))
+    s = (s + 1) & mask;
+  return (int)s;
+}
+
+const Category *categoryFind(const CategoryIndex *idx, const char *name)
+{
+  int s = categorySlot(idx, name, termHash(name));
+  return idx->slots[s].id == -1 ? NULL : &idx->list[idx->slots[s].id];
+}
+
+/* Interns name if it is new and files note under it; returns the category id */
+int categoryAdd(CategoryIndex *idx, const char *name, int note)
+{
+  uint32_t hash = termHash(name);
+  int s = categorySlot(idx, name, hash);
+  int id = idx->slots[s].id;
+
+  if (id == -1)
+  {
+    if (idx->count == idx->capacity)
+    {
+      idx->capacity = idx->capacity ? idx->capacity * 2 : 16;
+      idx->list = (Category *)checkedRealloc(idx->list, sizeof(Category) * idx->capacity);
+    }
+    id = idx->count++;
+    Category *c = &idx->list[id];
+    c->name = (char *)checkedRealloc(NULL, strlen(name) + 1);
+    strcpy(c->name, name);
+    c->notes = NULL;
+    c->count = 0;
+    c->capacity = 0;
+    idx->slots[s].hash = hash;
+    idx->slots[s].id = id;
+
+    if (idx->count * 2 > idx->slotCapacity)
+    {
+      free(idx->slots);
+      idx->slotCapacity *= 2;
+      idx->slots = (CategorySlot *)checkedRealloc(NULL, sizeof(CategorySlot) * idx->slotCapacity);
+      for (int i = 0; i < idx->slotCapacity; i++)
+        idx->slots[i].id = -1;
+      for (int i = 0; i < idx->count; i++)
+      {
+        uint32_t h = termHash(idx->list[i].name);
+        int t = categorySlot(idx, idx->list[i].name, h);
+        idx->slots[t].hash = h;
+        idx->slots[t].id = i;
+      }
+    }
+  }
+
+  Category *c = &idx->list[id];
+  if (c->count == c->capacity)
+  {
+    c->capacity = c->capacity ? c->capacity * 2 : 8;
+    c->notes = (int *)checkedRealloc(c->notes, sizeof(int) * c->capacity);
+  }
+  /* new notes go last; an edited one moving in goes back to its place */
+  int at = c->count;
+  while (at > 0 && c->notes[at - 1] > note)
+    at--;
+  memmove(c->notes + at + 1, c->notes + at, sizeof(int) * (c->count - at));
+  c->notes[at] = note;
+  c->count++;
+  return id;
+}
+
+void categoryRemove(CategoryIndex *idx, const char *name, int note)
+{
+  Category *c = (Category *)categoryFind(idx, name);
+  if (!c)
+    return;
+  int lo = 0, hi = c->count;
+  while (lo < hi)
+  {
+    int mid = lo + (hi - lo) / 2;
+    if (c->notes[mid] < note)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < c->count && c->notes[lo] == note)
+  {
+    memmove(c->notes + lo, c->notes + lo + 1, sizeof(int) * (c->count - lo - 1));
+    c->count--;
+  }
+}
+
+/* ================= COMPRESSED ARCHIVE ================= */
+
+/*
+ * A small LZ77 codec in the LZ4 block layout: each sequence is a token
+ * (literal count in the high nibble, match length - 4 in the low one),
+ * extra length bytes of 255 when a nibble overflows, the literals, and a
+ * two-byte little-endian match offset. The last sequence has literals only.
+ */
+static size_t lzBound(size_t n)
+{
+  return n + n / 255 + 16;
+}
+
+static uint32_t lzRead32(const uint8_t *p)
+{
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t lzHash(uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t *lzPutLength(uint8_t *op, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    *op++ = 255;
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+/* matchLen 0 writes the closing literals-only sequence */
+static uint8_t *lzSequence(uint8_t *op, const uint8_t *literals, size_t litLen,
+                           size_t offset, size_t matchLen)
+{
+  size_t extra = matchLen ? matchLen - LZ_MIN_MATCH : 0;
+  *op++ = (uint8_t)((litLen < 15 ? litLen : 15) << 4 | (extra < 15 ? extra : 15));
+  if (litLen >= 15)
+    op = lzPutLength(op, litLen - 15);
+  memcpy(op, literals, litLen);
+  op += litLen;
+  if (matchLen == 0)
+    return op;
+  *op++ = (uint8_t)offset;
+  *op++ = (uint8_t)(offset >> 8);
+  if (extra >= 15)
+    op = lzPutLength(op, extra - 15);
+  return op;
+}
+
+/* Compresses n bytes into dst, which must hold lzBound(n); returns the size */
+size_t lzCompress(const uint8_t *src, size_t n, uint8_t *dst)
+{
+  static uint32_t table[1 << LZ_HASH_BITS];
+  const uint8_t *ip = src, *anchor = src, *end = src + n;
+  uint8_t *op = dst;
+
+  memset(table, 0, sizeof(table));
+  while (end - ip >= LZ_MIN_MATCH)
+  {
+    uint32_t seq = lzRead32(ip);
+    uint32_t h = lzHash(seq);
+    const uint8_t *ref = src + table[h];
+    table[h] = (uint32_t)(ip - src);
+    if (ref >= ip || ip - ref > LZ_MAX_OFFSET || lzRead32(ref) != seq)
+    {
+      ip++;
+      continue;
+    }
+
+    const uint8_t *m = ip + LZ_MIN_MATCH, *r = ref + LZ_MIN_MATCH;
+    while (m < end && *m == *r)
+      m++, r++;
+    op = lzSequence(op, anchor, ip - anchor, ip - ref, m - ip);
+    if (end - m >= LZ_MIN_MATCH)
+      table[lzHash(lzRead32(m - 2))] = (uint32_t)(m - 2 - src);
+    ip = anchor = m;
+  }
+  op = lzSequence(op, anchor, end - anchor, 0, 0);
+  return op - dst;
+}
+
+static int lzGetLength(const uint8_t **ip, const uint8_t *end, size_t *len)
+{
+  uint8_t b;
+  do
+  {
+    if (*ip >= end)
+      return -1;
+    b = *(*ip)++;
+    *len += b;
+  } while (b == 255);
+  return 0;
+}
+
+/* Returns the decompressed size, or -1 when src is not a valid stream for capacity */
+long lzDecompress(const uint8_t *src, size_t n, uint8_t *dst, size_t capacity)
+{
+  const uint8_t *ip = src, *end = src + n;
+  uint8_t *op = dst, *limit = dst + capacity;
+
+  while (ip < end)
+  {
+    unsigned token = *ip++;
+    size_t len = token >> 4;
+    if ((len == 15 && lzGetLength(&ip, end, &len) != 0) ||
+        (size_t)(end - ip) < len || (size_t)(limit - op) < len)
+      return -1;
+    if (len <= 16 && end - ip >= 16 && limit - op >= 16)
+      memcpy(op, ip, 16); /* one fixed-size copy covers the common short run */
+    else
+      memcpy(op, ip, len);
+    op += len;
+    ip += len;
+    if (ip == end)
+      break;
+
+    if (end - ip < 2)
+      return -1;
+    size_t offset = ip[0] | (size_t)ip[1] << 8;
+    ip += 2;
+    len = token & 15;
+    if (len == 15 && lzGetLength(&ip, end, &len) != 0)
+      return -1;
+    len += LZ_MIN_MATCH;
+    if (offset == 0 || offset > (size_t)(op - dst) || (size_t)(limit - op) < len)
+      return -1;
+
+    const uint8_t *m = op - offset;
+    if (offset >= 16 && len <= 16 && limit - op >= 16)
+      memcpy(op, m, 16);
+    else if (offset >= len)
+      memcpy(op, m, len);
+    else
+    {
+      uint8_t *stop = op + len;
+      while (op < stop)
+        *op++ = *m++; /* overlapping copy repeats the last offset bytes */
+      continue;
+    }
+    op += len;
+  }
+  return (long)(op - dst);
+}
+
+/* FNV-1a taken eight bytes at a step, so checking a block costs little next to decoding it */
+static uint64_t blockChecksum(const uint8_t *p, size_t len)
+{
+  uint64_t h = 14695981039346656037ull;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8)
+  {
+    uint64_t word;
+    memcpy(&word, p + i, sizeof(word));
+    h ^= word;
+    h *= 1099511628211ull;
+  }
+  return checksum64(h, p + i, len - i);
+}
+
+/* Writes every note to notes.arc; returns the archive's size, or 0 if it failed */
+uint64_t writeArchive(NoteList *list)
+{
+  FILE *fp = fopen(ARCHIVE_TEMP_FILENAME, "wb");
+  if (!fp)
+    return 0;
+
+  ArchiveHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, ARCHIVE_MAGIC, 4);
+  h.version = ARCHIVE_VERSION;
+  h.count = (uint32_t)list->count;
+  int failed = fwrite(&h, sizeof(h), 1, fp) != 1;
+
+  ArchiveBlock *blocks = NULL;
+  int blockCapacity = 0;
+  uint8_t *raw = NULL, *packed = NULL;
+  size_t rawCapacity = 0, packedCapacity = 0;
+  uint64_t offset = sizeof(h);
+
+  for (int first = 0; first < list->count && !failed;)
+  {
+    /* whole notes until the block reaches its size */
+    size_t rawSize = 0;
+    int last = first;
+    while (last < list->count && rawSize < ARCHIVE_BLOCK_SIZE)
+    {
+      rawSize += sizeof(Note) + savedTextSize(noteAt(list, last++));
+    }
+    if (rawSize > rawCapacity)
+    {
+      rawCapacity = rawSize;
+      raw = (uint8_t *)checkedRealloc(raw, rawCapacity);
+    }
+    if (lzBound(rawSize) > packedCapacity)
+    {
+      packedCapacity = lzBound(rawSize);
+      packed = (uint8_t *)checkedRealloc(packed, packedCapacity);
+    }
+
+    Note *headers = (Note *)raw;
+    uint8_t *text = raw + sizeof(Note) * (last - first);
+    uint64_t textUsed = 0;
+    for (int i = first; i < last; i++)
+    {
+      const Note *n = noteAt(list, i);
+      size_t len = savedTextSize(n);
+      headers[i - first] = savedNote(n, textUsed);
+      memcpy(text + textUsed, savedText(list, n), len);
+      textUsed += len;
+    }
+
+    if (h.blockCount == (uint32_t)blockCapacity)
+    {
+      blockCapacity = blockCapacity ? blockCapacity * 2 : 64;
+      blocks = (ArchiveBlock *)checkedRealloc(blocks, sizeof(ArchiveBlock) * blockCapacity);
+    }
+    ArchiveBlock *b = &blocks[h.blockCount++];
+    b->offset = offset;
+    b->packedSize = (uint32_t)lzCompress(raw, rawSize, packed);
+    b->rawSize = (uint32_t)rawSize;
+    b->firstNote = (uint32_t)first;
+    b->noteCount = (uint32_t)(last - first);
+    b->checksum = blockChecksum(packed, b->packedSize);
+    failed = fwrite(packed, 1, b->packedSize, fp) != b->packedSize;
+    offset += b->packedSize;
+    first = last;
+  }
+
+  h.directory = offset;
+  failed = failed || fwrite(blocks, sizeof(ArchiveBlock), h.blockCount, fp) != h.blockCount ||
+           fseek(fp, 0, SEEK_SET) != 0 || fwrite(&h, sizeof(h), 1, fp) != 1 || syncFile(fp);
+  free(blocks);
+  free(raw);
+  free(packed);
+  if (fclose(fp) != 0 || failed || rename(ARCHIVE_TEMP_FILENAME, ARCHIVE_FILENAME) != 0)
+  {
+    remove(ARCHIVE_TEMP_FILENAME);
+    return 0;
+  }
+  return h.directory + sizeof(ArchiveBlock) * (uint64_t)h.blockCount;
+}
+
+/* Writes every note to notes.arc, then reads it all back to check and time it */
+void saveArchive(NoteList *list)
+{
+  clock_t start = clock();
+  uint64_t archived = writeArchive(list);
+  if (!archived)
+  {
+    printf("Failed to write %s!\n", ARCHIVE_FILENAME);
+    return;
+  }
+  double writeSeconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  uint64_t plain = sizeof(NoteFileHeader) + sizeof(Note) * (uint64_t)list->count;
+  for (int i = 0; i < list->count; i++)
+    plain += savedTextSize(noteAt(list, i));
+  printf("Archived %d notes: %.1f MB -> %.1f MB (%.1f%%) in %.2f s\n", list->count,
+         plain / 1e6, archived / 1e6, plain ? 100.0 * archived / plain : 0.0, writeSeconds);
+
+  NoteList check;
+  initNoteList(&check);
+  start = clock();
+  loadArchive(&check);
+  printf("Read back %d notes in %.2f s\n", check.count,
+         (double)(clock() - start) / CLOCKS_PER_SEC);
+  freeNoteList(&check);
+}
+
+/* Header and directory of notes.arc, checked against each other; NULL when unusable */
+static ArchiveBlock *readArchiveDirectory(FILE *fp, ArchiveHeader *h)
+{
+  if (fread(h, sizeof(*h), 1, fp) != 1 || memcmp(h->magic, ARCHIVE_MAGIC, 4) != 0 ||
+      h->version < 1 || h->version > ARCHIVE_VERSION || fseek(fp, 0, SEEK_END) != 0)
+    return NULL;
+  long size = ftell(fp);
+  if (h->directory < sizeof(*h) || h->directory > (uint64_t)size ||
+      ((uint64_t)size - h->directory) / sizeof(ArchiveBlock) < h->blockCount)
+    return NULL;
+
+  ArchiveBlock *blocks = (ArchiveBlock *)malloc(sizeof(ArchiveBlock) * (h->blockCount + 1));
+  if (!blocks || fseek(fp, (long)h->directory, SEEK_SET) != 0 ||
+      fread(blocks, sizeof(ArchiveBlock), h->blockCount, fp) != h->blockCount)
+  {
+    free(blocks);
+    return NULL;
+  }
+  uint64_t notes = 0;
+  for (uint32_t i = 0; i < h->blockCount; i++)
+  {
+    const ArchiveBlock *b = &blocks[i];
+    if (b->firstNote != notes || b->offset < sizeof(*h) ||
+        b->offset + b->packedSize > h->directory ||
+        b->rawSize / sizeof(Note) < b->noteCount)
+    {
+      free(blocks);
+      return NULL;
+    }
+    notes += b->noteCount;
+  }
+  if (notes != h->count)
+  {
+    free(blocks);
+    return NULL;
+  }
+  return blocks;
+}
+
+/*
+ * Reads and decompresses one block into *raw, growing the buffers as
+ * needed. Returns the block's text size, or -1 if the block is damaged or
+ * any of its notes does not fit inside it.
+ */
+static long readArchiveBlock(FILE *fp, const ArchiveBlock *b, uint8_t **packed,
+                             size_t *packedCapacity, uint8_t **raw, size_t *rawCapacity)
+{
+  if (b->packedSize > *packedCapacity)
+  {
+    *packedCapacity = b->packedSize;
+    *packed = (uint8_t *)checkedRealloc(*packed, *packedCapacity);
+  }
+  if (b->rawSize > *rawCapacity)
+  {
+    *rawCapacity = b->rawSize;
+    *raw = (uint8_t *)checkedRealloc(*raw, *rawCapacity);
+  }
+  if (fseek(fp, (long)b->offset, SEEK_SET) != 0 ||
+      fread(*packed, 1, b->packedSize, fp) != b->packedSize ||
+      blockChecksum(*packed, b->packedSize) != b->checksum ||
+      lzDecompress(*packed, b->packedSize, *raw, b->rawSize) != (long)b->rawSize)
+    return -1;
+
+  const Note *headers = (const Note *)*raw;
+  const char *text = (const char *)(*raw + sizeof(Note) * b->noteCount);
+  uint64_t textSize = b->rawSize - sizeof(Note) * b->noteCount;
+  for (uint32_t i = 0; i < b->noteCount; i++)
+  {
+    Note n;
+    memcpy(&n, &headers[i], sizeof(n));
+    uint64_t end = n.text + n.titleLen + n.categoryLen + (uint64_t)n.contentLen + 3;
+    if (n.text >= end || end > textSize || text[n.text + n.titleLen] != '\0' ||
+        text[n.text + n.titleLen + 1 + n.categoryLen] != '\0' || text[end - 1] != '\0')
+      return -1;
+  }
+  return (long)textSize;
+}
+
+/*
+ * Loads every note from notes.arc into an empty list. The notes of a
+ * damaged block stay as deleted placeholders, so later notes keep their
+ * numbers. Returns 0 when there is no archive at all.
+ */
+int loadArchive(NoteList *list)
+{
+  FILE *fp = fopen(ARCHIVE_FILENAME, "rb");
+  if (!fp)
+    return 0;
+  ArchiveHeader h;
+  ArchiveBlock *blocks = readArchiveDirectory(fp, &h);
+  if (!blocks)
+  {
+    printf("%s is damaged, starting with no notes\n", ARCHIVE_FILENAME);
+    fclose(fp);
+    return 1;
+  }
+
+  /* one allocation each for the headers and the text of all blocks */
+  uint64_t textTotal = 0;
+  for (uint32_t i = 0; i < h.blockCount; i++)
+    textTotal += blocks[i].rawSize - sizeof(Note) * blocks[i].noteCount;
+  while ((uint32_t)list->capacity < h.count)
+    resizeNoteList(list);
+  if (textTotal > list->arenaCapacity)
+  {
+    list->arena = (char *)replaceBuffer(list, list->arena, list->arenaUsed, textTotal);
+    list->arenaCapacity = textTotal;
+  }
+
+  uint8_t *packed = NULL, *raw = NULL;
+  size_t packedCapacity = 0, rawCapacity = 0;
+  uint32_t skipped = 0;
+  for (uint32_t i = 0; i < h.blockCount; i++)
+  {
+    const ArchiveBlock *b = &blocks[i];
+    long textSize = readArchiveBlock(fp, b, &packed, &packedCapacity, &raw, &rawCapacity);
+    if (textSize < 0)
+    {
+      for (uint32_t j = 0; j < b->noteCount; j++)
+        notePlaceholder(list, list->count++);
+      skipped += b->noteCount;
+      continue;
+    }
+    if (list->arenaUsed + textSize > list->arenaCapacity)
+    {
+      size_t capacity = list->arenaUsed + textSize;
+      list->arena = (char *)replaceBuffer(list, list->arena, list->arenaUsed, capacity);
+      list->arenaCapacity = capacity;
+    }
+    uint64_t base = list->arenaUsed;
+    memcpy(list->arena + base, raw + sizeof(Note) * b->noteCount, textSize);
+    list->arenaUsed += textSize;
+    for (uint32_t j = 0; j < b->noteCount; j++)
+    {
+      Note *n = noteAt(list, list->count);
+      memcpy(n, raw + sizeof(Note) * j, sizeof(Note));
+      n->text += base;
+      if (h.version < 2)
+        n->flags = 0; /* version 1 blocks left these bytes as padding */
+      if (n->flags & NOTE_DELETED)
+        list->pageDeleted[list->count >> NOTE_PAGE_BITS]++;
+      indexNote(list, list->count);
+      list->count++;
+    }
+  }
+  free(packed);
+  free(raw);
+  free(blocks);
+  fclose(fp);
+
+  if (skipped)
+    printf("Skipped %u note(s) in damaged blocks of %s\n", skipped, ARCHIVE_FILENAME);
+  list->saved = 0;
+  list->appendable = 0;
+  return 1;
+}
+
+/* Prints note number (1-based) after decompressing only the block holding it */
+void showArchivedNote(long number)
+{
+  FILE *fp = fopen(ARCHIVE_FILENAME, "rb");
+  if (!fp)
+  {
+    printf("No %s; run 'archive' first\n", ARCHIVE_FILENAME);
+    return;
+  }
+  ArchiveHeader h;
+  ArchiveBlock *blocks = readArchiveDirectory(fp, &h);
+  if (!blocks || number < 1 || number > (long)h.count)
+  {
+    if (blocks)
+      printf("No note %ld in %s\n", number, ARCHIVE_FILENAME);
+    else
+      printf("%s is damaged\n", ARCHIVE_FILENAME);
+    free(blocks);
+    fclose(fp);
+    return;
+  }
+
+  uint32_t want = (uint32_t)(number - 1);
+  uint32_t lo = 0, hi = h.blockCount - 1;
+  while (lo < hi)
+  {
+    uint32_t mid = lo + (hi - lo + 1) / 2;
+    if (blocks[mid].firstNote <= want)
+      lo = mid;
+    else
+      hi = mid - 1;
+  }
+
+  const ArchiveBlock *b = &blocks[lo];
+  uint8_t *packed = NULL, *raw = NULL;
+  size_t packedCapacity = 0, rawCapacity = 0;
+  if (readArchiveBlock(fp, b, &packed, &packedCapacity, &raw, &rawCapacity) < 0)
+    printf("Block %u of %s is damaged\n", lo + 1, ARCHIVE_FILENAME);
+  else
+  {
+    Note n;
+    memcpy(&n, raw + sizeof(Note) * (want - b->firstNote), sizeof(n));
+    if (h.version >= 2 && (n.flags & NOTE_DELETED))
+      printf("\n(note %ld was deleted)", number);
+    const char *title = (const char *)raw + sizeof(Note) * b->noteCount + n.text;
+    const char *category = title + n.titleLen + 1;
+    char created_at[TIMESTAMP_LEN];
+    timestampText(n.created, created_at);
+    printf("\n[%ld] %s (%s) - %s, priority %d\n", number, title, category, created_at,
+           n.priority);
+    printf("%s\n", category + n.categoryLen + 1);
+    printf("\n(read block %u of %u: %u bytes, %u decompressed)\n", lo + 1, h.blockCount,
+           b->packedSize, b->rawSize);
+  }
+  free(packed);
+  free(raw);
+  free(blocks);
+  fclose(fp);
+}
+
+// Output
+/*
+=== NOTE MANAGEMENT SYSTEM ===
+
+1. Add Note
+2. View All Notes
+3. View Notes by Category
+4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
+Enter choice: 1
+
+Enter title: Meeting Notes
 Enter category: Work
 Enter content: Discuss project milestones and deadlines.
 Priority (1=High, 2=Medium, 3=Low): 1
@@ -282,6 +2952,13 @@ Note added successfully!
 2. View All Notes
 3. View Notes by Category
 4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
 Enter choice: 1
 
 Enter title: Grocery List
@@ -295,11 +2972,18 @@ Note added successfully!
 2. View All Notes
 3. View Notes by Category
 4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
 Enter choice: 1
 
 Enter title: Book to read
 Enter category: Leisure
-Enter content: Finish reading "The Greate Gatsby
+Enter content: Finish reading "The Great Gatsby"
 Priority (1=High, 2=Medium, 3=Low): 2
 
 Note added successfully!
@@ -308,6 +2992,13 @@ Note added successfully!
 2. View All Notes
 3. View Notes by Category
 4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
 Enter choice: 2
 
 === ALL NOTES ===
@@ -325,12 +3016,19 @@ Content: Milk, Bread, Eggs, Fruits.
 [3] Book to read (Leisure)
 Priority: 2
 Created: 2026-01-14 09:58:05
-Content: Finish reading "The Greate Gatsby
+Content: Finish reading "The Great Gatsby"
 
 1. Add Note
 2. View All Notes
 3. View Notes by Category
 4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
 Enter choice: 3
 
 Enter category to search: Work
@@ -342,6 +3040,120 @@ Discuss project milestones and deadlines.
 2. View All Notes
 3. View Notes by Category
 4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
+Enter choice: 5
+
+Search words: project deadlines
+
+[1] Meeting Notes (Work)  score 1.99
+Discuss project milestones and deadlines.
+
+1. Add Note
+2. View All Notes
+3. View Notes by Category
+4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
+Enter choice: 7
+
+How many notes: 2
+
+[1] Meeting Notes (Work) - 2026-01-14 09:55:01, priority 1
+Discuss project milestones and deadlines.
+
+[3] Book to read (Leisure) - 2026-01-14 09:58:05, priority 2
+Finish reading "The Great Gatsby"
+
+1. Add Note
+2. View All Notes
+3. View Notes by Category
+4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
+Enter choice: 10
+
+Enter note number: 2
+
+Grocery List (Personal), priority 3
+Milk, Bread, Eggs, Fruits.
+
+Press Enter to keep a field as it is.
+New title:
+New category:
+New content: Milk, Bread, Eggs, Fruits, Butter.
+New priority (1=High, 2=Medium, 3=Low):
+
+Note updated successfully!
+
+1. Add Note
+2. View All Notes
+3. View Notes by Category
+4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
+Enter choice: 11
+
+Enter note number: 3
+
+Note deleted successfully!
+
+1. Add Note
+2. View All Notes
+3. View Notes by Category
+4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
+Enter choice: 2
+
+=== ALL NOTES ===
+
+[1] Meeting Notes (Work)
+Priority: 1
+Created: 2026-01-14 09:55:01
+Content: Discuss project milestones and deadlines.
+
+[2] Grocery List (Personal)
+Priority: 3
+Created: 2026-01-14 09:56:06
+Content: Milk, Bread, Eggs, Fruits, Butter.
+
+1. Add Note
+2. View All Notes
+3. View Notes by Category
+4. Exit
+5. Search Notes
+6. List Categories
+7. Highest Priority Notes
+8. Notes Between Dates
+9. Latest Notes
+10. Edit Note
+11. Delete Note
 Enter choice: 4
 
 Exiting... Goodbye!
@@ -0,0 +1,268 @@
+//===============================================================================//
+//                      PHONE NUMBER VALIDATION / NORMALIZATION                  //
+//===============================================================================//
+//
+// Shared by contact_management.c and visitor_management_system.c. Everything
+// is static so each program still builds from its own single source file.
+//
+// Two rule sets exist because the programs historically differ:
+//   PHONE_DIGITS   : digits only, any length          (contact_management)
+//   PHONE_DIALABLE : digits, '+', '-' or ' ', 10..15   (visitor_management)
+//
+// The batch functions work on fixed-width fields of at most 16 bytes inside
+// an array of records (e.g. Contact.phone[15]) and use SSE2/AVX2 when the
+// compiler targets them, with a scalar fallback giving identical answers.
+
+#ifndef PHONE_UTILS_H
+#define PHONE_UTILS_H
+
+#include <string.h>
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define PHONE_FIELD_MAX 16
+#define PHONE_DIAL_MIN 10
+#define PHONE_DIAL_MAX 15
+#define PHONE_KEY_SHIFT 56 /* digit count sits above the value */
+
+typedef enum
+{
+  PHONE_DIGITS,
+  PHONE_DIALABLE
+} PhoneRule;
+
+/* ================= SCALAR ================= */
+
+static inline int phoneIsSeparator(char c)
+{
+  return c == '+' || c == '-' || c == ' ';
+}
+
+static inline int phoneIsDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static inline int phoneIsDigits(const char *phone)
+{
+  for (; *phone; phone++)
+    if (!phoneIsDigit(*phone))
+      return 0;
+  return 1;
+}
+
+static inline int phoneIsDialable(const char *phone)
+{
+  size_t len = strlen(phone);
+  if (len < PHONE_DIAL_MIN || len > PHONE_DIAL_MAX)
+    return 0;
+  for (size_t i = 0; i < len; i++)
+    if (!phoneIsDigit(phone[i]) && !phoneIsSeparator(phone[i]))
+      return 0;
+  return 1;
+}
+
+static inline int phoneIsValid(const char *phone, PhoneRule rule)
+{
+  return rule == PHONE_DIGITS ? phoneIsDigits(phone) : phoneIsDialable(phone);
+}
+
+/*
+ * Drops '+', '-' and ' ' so numbers compare digit for digit. Returns the
+ * canonical length, or -1 if the input holds anything else or does not fit.
+ */
+static inline int phoneCanonical(const char *phone, char *out, size_t size)
+{
+  size_t n = 0;
+  for (; *phone; phone++)
+  {
+    if (phoneIsSeparator(*phone))
+      continue;
+    if (!phoneIsDigit(*phone) || n + 1 >= size)
+      return -1;
+    out[n++] = *phone;
+  }
+  out[n] = '\0';
+  return (int)n;
+}
+
+/*
+ * Canonical number as one integer: digit count in the top byte, the digits
+ * as a decimal value below it, so "0123" and "123" stay distinct. Returns
+ * 0 for an empty, invalid or over-long (more than 16 digit) number.
+ */
+static inline unsigned long long phoneKey(const char *phone)
+{
+  char digits[PHONE_FIELD_MAX + 1];
+  int len = phoneCanonical(phone, digits, sizeof(digits));
+  if (len <= 0)
+    return 0;
+  unsigned long long value = 0;
+  for (int i = 0; i < len; i++)
+    value = value * 10 + (unsigned long long)(digits[i] - '0');
+  return (unsigned long long)len << PHONE_KEY_SHIFT | value;
+}
+
+/* Scalar reference for one fixed-width field; the SIMD paths must agree */
+static inline int phoneFieldValid(const char *field, size_t width, PhoneRule rule)
+{
+  char tmp[PHONE_FIELD_MAX + 1];
+  const char *end = (const char *)memchr(field, '\0', width);
+  if (!end)
+    return 0;
+  memcpy(tmp, field, end - field + 1);
+  return phoneIsValid(tmp, rule);
+}
+
+/* ================= SIMD ================= */
+
+#if defined(__SSE2__)
+
+/*
+ * Whether a 16-byte load at record i would run past the end of the last
+ * field. That is only the final record when stride >= 16, but several of
+ * the last ones when records are narrower.
+ */
+static inline int phoneNearEnd(int i, int n, size_t stride, size_t width)
+{
+  return (size_t)i * stride + PHONE_FIELD_MAX > (size_t)(n - 1) * stride + width;
+}
+
+/*
+ * One 16-byte load starting at the field. Lanes past width belong to the
+ * next record and are ignored by phoneVerdict; fields near the end are
+ * copied out first so the load never runs past the array.
+ */
+static inline __m128i phoneLoad(const char *field, size_t width, int nearEnd)
+{
+  if (nearEnd)
+  {
+    char tmp[PHONE_FIELD_MAX] = {0};
+    memcpy(tmp, field, width);
+    return _mm_loadu_si128((const __m128i *)tmp);
+  }
+  return _mm_loadu_si128((const __m128i *)field);
+}
+
+/* Bitmask of lanes holding an allowed character under rule */
+static inline unsigned phoneAllowedMask(__m128i v, PhoneRule rule)
+{
+  __m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+  __m128i ok = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+  if (rule == PHONE_DIALABLE)
+  {
+    ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8('+')));
+    ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    ok = _mm_or_si128(ok, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+  }
+  return (unsigned)_mm_movemask_epi8(ok);
+}
+
+/* Applies the length rule and checks every lane before the terminator */
+static inline int phoneVerdict(unsigned allowed, unsigned zeros, size_t width,
+                               PhoneRule rule)
+{
+  zeros &= (1u << width) - 1;
+  if (zeros == 0)
+    return 0; /* no terminator inside the field */
+  unsigned len = (unsigned)__builtin_ctz(zeros);
+  unsigned before = (1u << len) - 1;
+  if ((allowed & before) != before)
+    return 0;
+  return rule == PHONE_DIGITS || (len >= PHONE_DIAL_MIN && len <= PHONE_DIAL_MAX);
+}
+
+#endif
+
+/*
+ * ok[i] = whether the field at base + i * stride passes rule. Fields are
+ * width bytes wide (width <= 16) and must be NUL-terminated within it.
+ */
+static inline void phoneValidateBatch(const char *base, size_t stride, size_t width,
+                                      int n, PhoneRule rule, unsigned char *ok)
+{
+  int i = 0;
+  if (width > PHONE_FIELD_MAX)
+  {
+    for (; i < n; i++)
+      ok[i] = (unsigned char)phoneFieldValid(base + i * stride, width, rule);
+    return;
+  }
+
+#if defined(__AVX2__)
+  /* two fields per 256-bit register */
+  for (; i + 2 < n; i += 2)
+  {
+    const char *a = base + i * stride, *b = a + stride;
+    __m256i v = _mm256_set_m128i(phoneLoad(b, width, phoneNearEnd(i + 1, n, stride, width)),
+                                 phoneLoad(a, width, phoneNearEnd(i, n, stride, width)));
+    __m256i d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    __m256i allowed = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+    if (rule == PHONE_DIALABLE)
+    {
+      allowed = _mm256_or_si256(allowed, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')));
+      allowed = _mm256_or_si256(allowed, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+      allowed = _mm256_or_si256(allowed, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+    }
+    unsigned am = (unsigned)_mm256_movemask_epi8(allowed);
+    unsigned zm = (unsigned)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+    ok[i] = (unsigned char)phoneVerdict(am & 0xffff, zm & 0xffff, width, rule);
+    ok[i + 1] = (unsigned char)phoneVerdict(am >> 16, zm >> 16, width, rule);
+  }
+#endif
+
+#if defined(__SSE2__)
+  for (; i < n; i++)
+  {
+    __m128i v = phoneLoad(base + i * stride, width, phoneNearEnd(i, n, stride, width));
+    unsigned zm = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    ok[i] = (unsigned char)phoneVerdict(phoneAllowedMask(v, rule), zm, width, rule);
+  }
+#else
+  for (; i < n; i++)
+    ok[i] = (unsigned char)phoneFieldValid(base + i * stride, width, rule);
+#endif
+}
+
+/*
+ * Rewrites each field in place to its canonical digits-only form. ok[i] is
+ * cleared for fields that hold characters other than digits and separators.
+ * Fields without separators (the common case) are detected and left alone.
+ */
+static inline void phoneCanonicalizeBatch(char *base, size_t stride, size_t width,
+                                          int n, unsigned char *ok)
+{
+  if (width > PHONE_FIELD_MAX)
+  {
+    memset(ok, 0, n);
+    return;
+  }
+
+  phoneValidateBatch(base, stride, width, n, PHONE_DIGITS, ok);
+  for (int i = 0; i < n; i++)
+  {
+    char *field = base + i * stride;
+    char tmp[PHONE_FIELD_MAX + 1], out[PHONE_FIELD_MAX + 1];
+    const char *end = (const char *)memchr(field, '\0', width);
+    if (ok[i] || !end)
+      continue;
+
+    memcpy(tmp, field, end - field + 1);
+    int len = phoneCanonical(tmp, out, sizeof(out));
+    ok[i] = len >= 0;
+    if (len >= 0)
+    {
+      memset(field, 0, width);
+      memcpy(field, out, len);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,98 @@
+//===============================================================================//
+//                        CHUNKED FILE LOADING WITH PROGRESS                     //
+//===============================================================================//
+//
+// Shared by note_management_system.c and visitor_management_system.c. The
+// loaders check a file's header against its real size first, allocate the
+// destination once, then pull the body through streamRead in fixed chunks,
+// so a large file never needs a second copy or stdio buffer of its size.
+// Files of STREAM_REPORT_BYTES or more get a progress line and a final
+// throughput figure on stderr, so dumps on stdout stay clean; smaller ones
+// load silently.
+
+#ifndef STREAM_LOAD_H
+#define STREAM_LOAD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define STREAM_CHUNK_BYTES (4u << 20)
+#define STREAM_REPORT_BYTES (64u << 20)
+
+typedef struct
+{
+  const char *name;
+  uint64_t total; /* bytes expected */
+  uint64_t done;
+  int percent; /* last percentage printed, -1 before the first */
+  int verbose;
+  struct timespec start;
+} StreamLoad;
+
+/* Size of fp in bytes, or -1; leaves the position at offset */
+static inline long streamFileSize(FILE *fp, long offset)
+{
+  if (fseek(fp, 0, SEEK_END) != 0)
+    return -1;
+  long size = ftell(fp);
+  return fseek(fp, offset, SEEK_SET) == 0 ? size : -1;
+}
+
+static inline void streamBegin(StreamLoad *s, const char *name, uint64_t total)
+{
+  s->name = name;
+  s->total = total;
+  s->done = 0;
+  s->percent = -1;
+  s->verbose = total >= STREAM_REPORT_BYTES;
+  clock_gettime(CLOCK_MONOTONIC, &s->start);
+}
+
+static inline double streamSeconds(const StreamLoad *s)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - s->start.tv_sec) + (now.tv_nsec - s->start.tv_nsec) / 1e9;
+}
+
+static inline void streamAdvance(StreamLoad *s, uint64_t bytes)
+{
+  s->done += bytes;
+  if (!s->verbose)
+    return;
+  int percent = (int)(s->done * 100 / s->total);
+  if (percent != s->percent)
+  {
+    s->percent = percent;
+    fprintf(stderr, "\rLoading %s... %3d%%", s->name, percent);
+  }
+}
+
+/* Reads exactly bytes into dst a chunk at a time; 0 on success */
+static inline int streamRead(FILE *fp, void *dst, uint64_t bytes, StreamLoad *s)
+{
+  unsigned char *out = (unsigned char *)dst;
+  while (bytes > 0)
+  {
+    size_t n = bytes < STREAM_CHUNK_BYTES ? (size_t)bytes : STREAM_CHUNK_BYTES;
+    if (fread(out, 1, n, fp) != n)
+      return -1;
+    out += n;
+    bytes -= n;
+    streamAdvance(s, n);
+  }
+  return 0;
+}
+
+/* Ends the progress line with the size and rate of what was read */
+static inline void streamEnd(const StreamLoad *s)
+{
+  if (!s->verbose)
+    return;
+  double seconds = streamSeconds(s);
+  fprintf(stderr, "\rLoaded %s: %.1f MB in %.2f s (%.0f MB/s)\n", s->name, s->done / 1e6,
+          seconds, seconds > 0 ? s->done / 1e6 / seconds : 0.0);
+}
+
+#endif
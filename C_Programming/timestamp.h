@@ -0,0 +1,107 @@
+//===============================================================================//
+//                           CACHED TIMESTAMP FORMATTING                         //
+//===============================================================================//
+//
+// Shared by note_management_system.c and visitor_management_system.c. Times
+// are kept as raw int64 seconds since the epoch and rendered as
+// "YYYY-MM-DD HH:MM:SS" local time. The expensive part, localtime_r and
+// strftime, runs once per minute per thread: later times in the same minute
+// only have their two seconds digits patched into the cached text.
+
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define TIMESTAMP_LEN 20 /* "YYYY-MM-DD HH:MM:SS" and its NUL */
+
+typedef struct
+{
+  int64_t minute; /* epoch second at which the cached local minute starts */
+  int valid;
+  char text[TIMESTAMP_LEN];
+} TimestampCache;
+
+/* Seconds since the epoch, the form times are stored and compared in */
+static inline int64_t timestampNow(void)
+{
+  return (int64_t)time(NULL);
+}
+
+/* Formats when into out (TIMESTAMP_LEN bytes) through cache */
+static inline void timestampFormat(TimestampCache *cache, int64_t when, char *out)
+{
+  if (!cache->valid || when < cache->minute || when >= cache->minute + 60)
+  {
+    struct tm local;
+    time_t t = (time_t)when;
+    if (localtime_r(&t, &local) == NULL)
+    {
+      strcpy(out, "0000-00-00 00:00:00");
+      return;
+    }
+    strftime(cache->text, TIMESTAMP_LEN, "%Y-%m-%d %H:%M:%S", &local);
+    /* tm_sec is 60 only on a leap second; keep that one out of the cache */
+    cache->minute = when - (local.tm_sec < 60 ? local.tm_sec : 0);
+    cache->valid = local.tm_sec < 60;
+    memcpy(out, cache->text, TIMESTAMP_LEN);
+    return;
+  }
+
+  int seconds = (int)(when - cache->minute);
+  cache->text[17] = (char)('0' + seconds / 10);
+  cache->text[18] = (char)('0' + seconds % 10);
+  memcpy(out, cache->text, TIMESTAMP_LEN);
+}
+
+/* timestampFormat with a cache private to the calling thread */
+static inline void timestampText(int64_t when, char *out)
+{
+  static _Thread_local TimestampCache cache;
+  timestampFormat(&cache, when, out);
+}
+
+/*
+ * "YYYY-MM-DD", "YYYY-MM-DD HH:MM" or "YYYY-MM-DD HH:MM:SS" in local time.
+ * A bare date means the start of that day, or its last second when
+ * endOfDay is set. Returns -1 for anything else, including trailing text
+ * and fields out of range (2026-02-31), which mktime would roll over.
+ */
+static inline int64_t timestampParse(const char *text, int endOfDay)
+{
+  struct tm t, want;
+  int dateEnd = -1, minuteEnd = -1, secondEnd = -1;
+  memset(&t, 0, sizeof(t));
+  int fields = sscanf(text, "%d-%d-%d%n %d:%d%n:%d%n", &t.tm_year, &t.tm_mon, &t.tm_mday,
+                      &dateEnd, &t.tm_hour, &t.tm_min, &minuteEnd, &t.tm_sec, &secondEnd);
+  int used = fields == 3 ? dateEnd : fields == 5 ? minuteEnd : fields == 6 ? secondEnd : -1;
+  if (used < 0 || text[used] != '\0')
+    return -1;
+  if (fields == 3 && endOfDay)
+  {
+    t.tm_hour = 23;
+    t.tm_min = 59;
+    t.tm_sec = 59;
+  }
+  t.tm_year -= 1900;
+  t.tm_mon -= 1;
+  t.tm_isdst = -1;
+  want = t;
+  time_t when = mktime(&t);
+  if (when == (time_t)-1 || t.tm_year != want.tm_year || t.tm_mon != want.tm_mon ||
+      t.tm_mday != want.tm_mday || t.tm_hour != want.tm_hour || t.tm_min != want.tm_min ||
+      t.tm_sec != want.tm_sec)
+    return -1;
+  return (int64_t)when;
+}
+
+/* The current local time as text */
+static inline void timestampCurrent(char *out)
+{
+  timestampText(timestampNow(), out);
+}
+
+#endif
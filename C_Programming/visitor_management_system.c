@@ -1,54 +1,254 @@
 //===================================================================================//
 //                          Visitor Management System                                //
 //===================================================================================//
+//
+// Visits are logged to one segment file per check-in day under visitor_log/,
+// listed in a small manifest. Check-in and check-out append one record and
+// patch one manifest row in place, so their cost does not grow with history.
+// Only the last LOG_RECENT_DAYS days, plus anyone still on site, are loaded
+// at startup; older days are read from their segments when a query needs them.
+//
+// "visitor_management_system check" runs the self-checks against a scratch log.
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
 #include <time.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "phone_utils.h"
+#include "stream_load.h"
+#include "timestamp.h"
 
 #define INITIAL_CAPACITY 5
 #define MAX_NAME_LEN 50
 #define MAX_PHONE_LEN 15
-#define FILENAME "visitors.dat"
+#define FILENAME "visitors.dat" /* the single-file format, moved into the log */
+#define LOAD_CHUNK 8192         /* visitors per read while loading */
+#define FILE_MAGIC "VIST"
+#define FILE_VERSION 2 /* 1 was a bare int count and text visit times */
+#define LOG_DIR "visitor_log"
+#define MANIFEST_FILENAME LOG_DIR "/manifest.dat"
+#define MANIFEST_MAGIC "VMAN"
+#define LOG_VERSION 1
+#define RECORD_IN "VIN "
+#define RECORD_OUT "VOUT"
+#define LOG_RECENT_DAYS 30         /* days of segments loaded at startup */
+#define VISIT_RING_HOURS (24 * 31) /* hours of history the time index covers */
+#define INPUT_LEN 64
+#define PATH_LEN 64
+#define CHECK_VISITS 400   /* visits the self-check spreads over CHECK_DAYS */
+#define CHECK_DAYS 60
+#define CHECK_WINDOWS 500  /* random windows compared against a full scan */
 
 //====================Data Structure====================
 typedef struct
 {
   char name[MAX_NAME_LEN];
   char phone[MAX_PHONE_LEN];
-  char visit_time[20];
+  int64_t id;    /* visit number, shown as the visitor ID */
+  int64_t entry; /* check-in, seconds since the epoch */
+  int64_t exit;  /* check-out, 0 while the visitor is on site */
 } Visitor;
 
+/* A visitors.dat version 2 record */
+typedef struct
+{
+  char name[MAX_NAME_LEN];
+  char phone[MAX_PHONE_LEN];
+  int64_t entry;
+  int64_t exit;
+} StoredVisitor;
+
+/* A visitors.dat version 1 record */
+typedef struct
+{
+  char name[MAX_NAME_LEN];
+  char phone[MAX_PHONE_LEN];
+  char visit_time[TIMESTAMP_LEN];
+} LegacyVisitor;
+
+typedef struct
+{
+  char magic[4];
+  int32_t version;
+  int32_t count;
+  int32_t reserved;
+} VisitorFileHeader;
+
+/*
+ * Segment files hold fixed-size records: RECORD_IN carries the whole visit,
+ * RECORD_OUT only the id and exit of a visit checked in earlier in the same
+ * segment. A torn last record is cut off before the next append.
+ */
+typedef struct
+{
+  char kind[4];
+  int32_t reserved;
+  Visitor visitor;
+} LogRecord;
+
+/* One manifest row per segment, kept sorted by day */
+typedef struct
+{
+  int32_t day; /* YYYYMMDD of the check-ins it holds */
+  int32_t count;
+  int32_t open;     /* visitors from this day still on site */
+  int32_t reserved;
+  int64_t lastExit; /* latest check-out, so range queries can skip the day */
+} LogDay;
+
+typedef struct
+{
+  char magic[4];
+  int32_t version;
+  int32_t dayCount;
+  int32_t reserved;
+  int64_t nextId;
+} ManifestHeader;
+
+typedef struct
+{
+  LogDay *days;
+  int dayCount;
+  int dayCapacity;
+  int64_t nextId;
+  FILE *manifest;
+  FILE *segment; /* today's segment, kept open for check-ins */
+  int32_t segmentDay;
+  int manifestStale; /* a manifest write failed; rewrite it whole next time */
+} VisitorLog;
+
+/* Visits overlapping one hour, as indexes into VisitorList.visitors */
+typedef struct
+{
+  int64_t hour; /* hours since the epoch, -1 while unused */
+  int *visits;
+  int count;
+  int capacity;
+} HourBucket;
+
+/*
+ * Slot hour % VISIT_RING_HOURS holds the visits overlapping that hour, so
+ * the ring covers the newest VISIT_RING_HOURS hours and reuses the oldest
+ * slot as time moves on. A visit joins its check-in hour at check-in and
+ * the rest of its hours at check-out; until then it sits in onSite.
+ */
+typedef struct
+{
+  HourBucket hours[VISIT_RING_HOURS];
+  int64_t newestHour; /* -1 while empty */
+  int *onSite;
+  int onSiteCount;
+  int onSiteCapacity;
+} VisitIndex;
+
+/*
+ * Holds every visit checked in from indexedFrom on, and everyone on site.
+ * Closed visits from before indexedFrom are answered from their segments.
+ */
 typedef struct
 {
   Visitor *visitors;
   int count;
   int capacity;
+  VisitIndex index;
+  VisitorLog log;
+  int64_t indexedFrom;
 } VisitorList;
 
+/* Tally of the self-check */
+typedef struct
+{
+  int passed;
+  int failed;
+} CheckRun;
+
 //====================Prototypes========================
 void initVisitorList(VisitorList *list);
 void freeVisitorList(VisitorList *list);
+int resizeVisitorList(VisitorList *list);
 int addVisitor(VisitorList *list);
+int checkOutVisitor(VisitorList *list);
+int checkOutAt(VisitorList *list, int slot);
 void displayAllVisitors(VisitorList *list);
-void saveToFile(VisitorList *list);
-int loadFromFile(VisitorList *list);
+void showVisitor(const Visitor *v);
+void showOnSite(VisitorList *list);
+int visitsBetween(VisitorList *list, int64_t from, int64_t to, int print);
+int indexedVisitsBetween(VisitorList *list, int64_t from, int64_t to, int print);
+int loggedVisitsBetween(VisitorList *list, int64_t from, int64_t to, int print, Visitor **keep);
+void keepIndexWindow(VisitorList *list);
+void showVisitsBetween(VisitorList *list);
+void showOccupancy(VisitorList *list);
+int occupancyOf(VisitorList *list, const char *date, int counts[24]);
+int64_t visitHour(int64_t when);
+int addToHour(VisitIndex *index, int64_t hour, int visit);
+int addToList(int **items, int *count, int *capacity, int value);
+void indexVisit(VisitorList *list, int i);
+int32_t dayOf(int64_t when);
+int64_t dayStart(int32_t day, int plusDays);
+void segmentPath(int32_t day, char *path);
+FILE *openSegment(int32_t day);
+int readSegment(int32_t day, Visitor **visits, int *count);
+int logDay(VisitorLog *log, int32_t day, int *added);
+void countVisit(VisitorLog *log, int row, const Visitor *v);
+int appendVisit(VisitorLog *log, const Visitor *v, int checkIn);
+int appendRuns(VisitorLog *log, const Visitor *visits, int count);
+int writeManifestHeader(VisitorLog *log);
+int writeManifestRow(VisitorLog *log, int row);
+int rewriteManifest(VisitorLog *log);
+int readManifest(VisitorLog *log);
+int rebuildManifest(VisitorLog *log);
+int openVisitorLog(VisitorList *list);
+void loadRecentVisits(VisitorList *list);
+void syncVisitorLog(VisitorLog *log);
+void pruneVisitorLog(VisitorList *list);
+int migrateOldFile(VisitorList *list);
+int loadStored(VisitorList *list, FILE *file, long size);
+int loadLegacy(VisitorList *list, FILE *file, long size);
+int reserveVisitors(VisitorList *list, int count);
+int readText(const char *prompt, char *text, int size);
 void displayMenu();
 int getValidChoice();
 void clearInputBuffer();
 int isValidPhone(const char *phone);
-void getCurrentTime(char *timeStr);
+void expect(CheckRun *run, int ok, const char *what);
+uint32_t checkRandom(uint32_t *state);
+Visitor checkVisitor(int64_t id, int64_t entry, int64_t exit);
+int fileExists(const char *path);
+void removeLogFiles(void);
+int reopenVisitors(VisitorList *list);
+int scanVisitsBetween(const Visitor *all, int count, int64_t from, int64_t to, int64_t now);
+int occupancyMismatches(VisitorList *list, int64_t when);
+int windowMismatches(VisitorList *list, const Visitor *all, int count, uint32_t *state);
+void checkWindowQueries(CheckRun *run);
+void checkManifestRepair(CheckRun *run);
+void checkTornRecords(CheckRun *run);
+void checkMigration(CheckRun *run);
+int runChecks(void);
 
 //====================Main Functions====================
-int main()
+int main(int argc, char *argv[])
 {
   VisitorList visitors;
   int choice;
 
+  /* the self-check works on its own log in a scratch directory */
+  if (argc == 2 && strcmp(argv[1], "check") == 0)
+    return runChecks() ? 0 : 1;
+
   initVisitorList(&visitors);
-  loadFromFile(&visitors);
+  if (!openVisitorLog(&visitors))
+  {
+    freeVisitorList(&visitors);
+    return 1;
+  }
 
   printf("\n=== VISITOR MANAGEMENT SYSTEM ===\n");
   printf("==================================\n");
@@ -63,8 +263,7 @@ int main()
     case 1:
       if (addVisitor(&visitors))
       {
-        printf("\n Visitor added successfully!\n");
-        saveToFile(&visitors);
+        printf("\n Visitor checked in successfully!\n");
       }
       break;
 
@@ -73,7 +272,7 @@ int main()
       break;
 
     case 3:
-      saveToFile(&visitors);
+      syncVisitorLog(&visitors.log);
       printf("\n Data saved successfully!\n");
       break;
 
@@ -82,6 +281,29 @@ int main()
       freeVisitorList(&visitors);
       return 0;
 
+    case 5:
+      if (checkOutVisitor(&visitors))
+      {
+        printf("\n Visitor checked out successfully!\n");
+      }
+      break;
+
+    case 6:
+      showOnSite(&visitors);
+      break;
+
+    case 7:
+      showVisitsBetween(&visitors);
+      break;
+
+    case 8:
+      showOccupancy(&visitors);
+      break;
+
+    case 9:
+      pruneVisitorLog(&visitors);
+      break;
+
     default:
       printf("\n Invalid choice! Please try again.\n");
     }
@@ -104,6 +326,16 @@ void initVisitorList(VisitorList *list)
     printf("❌ Memory allocation failed!\n");
     exit(1);
   }
+
+  memset(&list->index, 0, sizeof(list->index));
+  list->index.newestHour = -1;
+  for (int h = 0; h < VISIT_RING_HOURS; h++)
+    list->index.hours[h].hour = -1;
+
+  memset(&list->log, 0, sizeof(list->log));
+  list->log.nextId = 1;
+  list->log.segmentDay = -1;
+  list->indexedFrom = 0;
 }
 
 void freeVisitorList(VisitorList *list)
@@ -113,30 +345,46 @@ void freeVisitorList(VisitorList *list)
     free(list->visitors);
     list->visitors = NULL;
   }
+  for (int h = 0; h < VISIT_RING_HOURS; h++)
+  {
+    free(list->index.hours[h].visits);
+    list->index.hours[h].visits = NULL;
+  }
+  free(list->index.onSite);
+  list->index.onSite = NULL;
+
+  VisitorLog *log = &list->log;
+  if (log->segment)
+    fclose(log->segment);
+  if (log->manifest)
+    fclose(log->manifest);
+  free(log->days);
+  memset(log, 0, sizeof(*log));
 }
 
-void resizeVisitorList(VisitorList *list)
+int resizeVisitorList(VisitorList *list)
 {
-  list->capacity *= 2;
-  Visitor *temp = (Visitor *)realloc(list->visitors, list->capacity * sizeof(Visitor));
+  Visitor *temp = (Visitor *)realloc(list->visitors, list->capacity * 2 * sizeof(Visitor));
   if (temp == NULL)
   {
     printf("Memory reallocation failed. Continuing with current capacity.\n");
-    return;
+    return 0;
   }
   list->visitors = temp;
+  list->capacity *= 2;
+  return 1;
 }
 
 int addVisitor(VisitorList *list)
 {
-  if (list->count >= list->capacity)
+  if (list->count >= list->capacity && !resizeVisitorList(list))
   {
-    resizeVisitorList(list);
+    return 0;
   }
 
   Visitor *newVisitor = &list->visitors[list->count];
 
-  printf("\n--- Add New Visitor ---\n");
+  printf("\n--- Check In Visitor ---\n");
   printf("Enter visitor name: ");
 
   fgets(newVisitor->name, MAX_NAME_LEN, stdin);
@@ -152,206 +400,1680 @@ int addVisitor(VisitorList *list)
     return 0;
   }
 
-  getCurrentTime(newVisitor->visit_time);
+  newVisitor->id = list->log.nextId;
+  newVisitor->entry = timestampNow();
+  newVisitor->exit = 0;
+  if (!appendVisit(&list->log, newVisitor, 1))
+  {
+    printf(" Failed to save data!\n");
+    return 0;
+  }
 
   list->count++;
+  indexVisit(list, list->count - 1);
   return 1;
 }
 
-void displayAllVisitors(VisitorList *list)
+int checkOutVisitor(VisitorList *list)
 {
-  if (list->count == 0)
+  VisitIndex *index = &list->index;
+  if (index->onSiteCount == 0)
   {
-    printf("\n No visitors recorded yet.\n");
-    return;
+    printf("\n Nobody is on site.\n");
+    return 0;
   }
 
-  printf("\n=== VISITOR REGISTER (Total: %d) ===\n", list->count);
-  printf("%-4s | %-20s | %-15s | %-19s\n", "ID", "NAME", "PHONE", "VISIT TIME");
-  printf("----------------------------------------------------------\n");
+  showOnSite(list);
+  printf("Enter visitor ID to check out: ");
+  long long id;
+  if (scanf("%lld", &id) != 1)
+    id = 0;
+  clearInputBuffer();
 
-  for (int i = 0; i < list->count; i++)
+  /* only on-site visitors can check out, so the on-site list is the search */
+  int slot = -1;
+  for (int i = 0; i < index->onSiteCount; i++)
+  {
+    if (list->visitors[index->onSite[i]].id == id)
+    {
+      slot = i;
+      break;
+    }
+  }
+  if (slot < 0)
   {
-    printf("%-4d | %-20s | %-15s | %-19s\n",
-           i + 1,
-           list->visitors[i].name,
-           list->visitors[i].phone,
-           list->visitors[i].visit_time);
+    printf(" No visitor with ID %lld is on site.\n", id);
+    return 0;
   }
+  return checkOutAt(list, slot);
 }
 
-void saveToFile(VisitorList *list)
+/* Checks out the visitor at slot of the on-site list as of now */
+int checkOutAt(VisitorList *list, int slot)
 {
-  FILE *file = fopen(FILENAME, "wb");
-  if (!file)
+  VisitIndex *index = &list->index;
+  int visit = index->onSite[slot];
+  Visitor *v = &list->visitors[visit];
+  int64_t now = timestampNow();
+  v->exit = now > v->entry ? now : v->entry;
+  if (!appendVisit(&list->log, v, 0))
   {
+    v->exit = 0;
     printf(" Failed to save data!\n");
-    return;
+    return 0;
   }
+  index->onSite[slot] = index->onSite[--index->onSiteCount];
 
-  fwrite(&list->count, sizeof(int), 1, file);
-  fwrite(list->visitors, sizeof(Visitor), list->count, file);
-  fclose(file);
+  /* the check-in hour already lists this visit; add the hours since */
+  int64_t first = visitHour(v->entry) + 1;
+  int64_t last = visitHour(v->exit);
+  if (first < last - VISIT_RING_HOURS + 1)
+    first = last - VISIT_RING_HOURS + 1;
+  for (int64_t h = first; h <= last; h++)
+    addToHour(index, h, visit);
+  return 1;
 }
 
-int loadFromFile(VisitorList *list)
+/* Reads the whole register back from the segments, a day at a time */
+void displayAllVisitors(VisitorList *list)
 {
-  FILE *file = fopen(FILENAME, "rb");
-  if (!file)
+  VisitorLog *log = &list->log;
+  long long total = 0;
+  for (int r = 0; r < log->dayCount; r++)
+    total += log->days[r].count;
+  if (total == 0)
   {
-    printf(" No existing data found. Starting fresh.\n");
-    return 0;
+    printf("\n No visitors recorded yet.\n");
+    return;
   }
 
-  fread(&list->count, sizeof(int), 1, file);
-  if (list->count > 0)
+  printf("\n=== VISITOR REGISTER (Total: %lld) ===\n", total);
+  printf("%-4s | %-20s | %-15s | %-19s | %-19s\n", "ID", "NAME", "PHONE", "CHECK-IN", "CHECK-OUT");
+  printf("------------------------------------------------------------------------------------\n");
+
+  for (int r = 0; r < log->dayCount; r++)
   {
-    while (list->count > list->capacity)
+    Visitor *visits;
+    int count;
+    if (readSegment(log->days[r].day, &visits, &count) != 0)
+    {
+      printf(" Could not read the visits of %d.\n", log->days[r].day);
+      continue;
+    }
+    for (int i = 0; i < count; i++)
     {
-      resizeVisitorList(list);
+      showVisitor(&visits[i]);
     }
-    fread(list->visitors, sizeof(Visitor), list->count, file);
+    free(visits);
   }
-  fclose(file);
-  printf(" Loaded %d visitors from file.\n", list->count);
+}
+
+void showVisitor(const Visitor *v)
+{
+  char entry[TIMESTAMP_LEN];
+  char left[TIMESTAMP_LEN] = "on site";
+  timestampText(v->entry, entry);
+  if (v->exit != 0)
+    timestampText(v->exit, left);
+  printf("%-4lld | %-20s | %-15s | %-19s | %-19s\n", (long long)v->id, v->name, v->phone, entry,
+         left);
+}
+
+void showOnSite(VisitorList *list)
+{
+  VisitIndex *index = &list->index;
+  printf("\n=== ON SITE NOW (Total: %d) ===\n", index->onSiteCount);
+  for (int i = 0; i < index->onSiteCount; i++)
+    showVisitor(&list->visitors[index->onSite[i]]);
+}
+
+int64_t visitHour(int64_t when)
+{
+  return when < 0 ? -1 : when / 3600;
+}
+
+int addToList(int **items, int *count, int *capacity, int value)
+{
+  if (*count == *capacity)
+  {
+    int grown = *capacity ? *capacity * 2 : 8;
+    int *temp = (int *)realloc(*items, grown * sizeof(int));
+    if (temp == NULL)
+      return 0;
+    *items = temp;
+    *capacity = grown;
+  }
+  (*items)[(*count)++] = value;
   return 1;
 }
 
-void displayMenu()
+/* Files visit under hour, recycling the slot if it still holds an older hour */
+int addToHour(VisitIndex *index, int64_t hour, int visit)
 {
-  printf("\n=========== MENU ===========\n");
-  printf("1. Add New Visitor\n");
-  printf("2. View All Visitors\n");
-  printf("3. Save Data \n");
-  printf("4. Exit\n");
-  printf("============================\n");
-  printf("Enter your choice (1-4): ");
+  if (hour < 0 || (index->newestHour >= 0 && hour <= index->newestHour - VISIT_RING_HOURS))
+    return 0; /* older than anything the ring still covers */
+
+  HourBucket *bucket = &index->hours[hour % VISIT_RING_HOURS];
+  if (bucket->hour != hour)
+  {
+    bucket->hour = hour;
+    bucket->count = 0;
+  }
+  if (hour > index->newestHour)
+    index->newestHour = hour;
+  return addToList(&bucket->visits, &bucket->count, &bucket->capacity, visit);
 }
 
-int getValidChoice()
+void indexVisit(VisitorList *list, int i)
 {
-  int choice;
-  while (scanf("%d", &choice) != 1 || choice < 1 || choice > 4)
+  VisitIndex *index = &list->index;
+  Visitor *v = &list->visitors[i];
+  int64_t first = visitHour(v->entry);
+
+  if (v->exit == 0)
   {
-    printf("Please enter a number between 1-4: ");
-    clearInputBuffer();
+    addToHour(index, first, i);
+    if (!addToList(&index->onSite, &index->onSiteCount, &index->onSiteCapacity, i))
+      printf(" Memory allocation failed; visitor %lld is missing from the on-site list.\n",
+             (long long)v->id);
+    return;
   }
-  clearInputBuffer();
-  return choice;
+
+  int64_t last = visitHour(v->exit);
+  if (first < last - VISIT_RING_HOURS + 1)
+    first = last - VISIT_RING_HOURS + 1;
+  for (int64_t h = first; h <= last; h++)
+    addToHour(index, h, i);
 }
 
-void clearInputBuffer()
+/*
+ * The ring drops old hours as time moves on; moving indexedFrom to the next
+ * midnight inside it hands those days over to their segments.
+ */
+void keepIndexWindow(VisitorList *list)
 {
-  int c;
-  while ((c = getchar()) != '\n')
-    ;
+  int64_t newest = list->index.newestHour;
+  if (newest < 0)
+    return;
+  int64_t ringStart = (newest - VISIT_RING_HOURS + 1) * 3600;
+  if (list->indexedFrom < ringStart)
+    list->indexedFrom = dayStart(dayOf(ringStart), 1);
 }
 
-int isValidPhone(const char *phone)
+/*
+ * Counts, and prints if asked, visits overlapping [from, to]. Only the hour
+ * buckets in the window are read: a visit spanning several of them is
+ * reported from the first, and visitors still on site from before the
+ * window come from the on-site list. Closed visits from before indexedFrom
+ * come from the segments of the days whose lastExit reaches the window.
+ */
+int visitsBetween(VisitorList *list, int64_t from, int64_t to, int print)
+{
+  if (to < from)
+    return 0;
+  keepIndexWindow(list);
+
+  /* a visit checked in before indexedFrom can have left inside any window */
+  int found = loggedVisitsBetween(list, from, to, print, NULL);
+  return found + indexedVisitsBetween(list, from, to, print);
+}
+
+/* The part of visitsBetween held in memory; keepIndexWindow must have run */
+int indexedVisitsBetween(VisitorList *list, int64_t from, int64_t to, int print)
 {
-  int len = strlen(phone);
-  if (len < 10 || len > 15)
+  VisitIndex *index = &list->index;
+  int found = 0;
+  if (to < from || index->newestHour < 0)
     return 0;
 
-  for (int i = 0; i < len; i++)
+  int64_t first = visitHour(from);
+  int64_t last = visitHour(to);
+  int64_t oldest = index->newestHour - VISIT_RING_HOURS + 1;
+  if (first < oldest)
+    first = oldest;
+  if (last > index->newestHour)
+    last = index->newestHour;
+
+  /* a visitor still on site counts as leaving now */
+  int64_t now = timestampNow();
+  for (int64_t h = first; h <= last; h++)
   {
-    if (!isdigit(phone[i]) && phone[i] != '+' && phone[i] != '-' && phone[i] != ' ')
+    HourBucket *bucket = &index->hours[h % VISIT_RING_HOURS];
+    if (bucket->hour != h)
+      continue;
+    for (int i = 0; i < bucket->count; i++)
     {
-      return 0;
+      Visitor *v = &list->visitors[bucket->visits[i]];
+      int64_t reportAt = visitHour(v->entry) > first ? visitHour(v->entry) : first;
+      int64_t left = v->exit != 0 ? v->exit : now;
+      if (reportAt != h || v->entry > to || left < from ||
+          (v->exit != 0 && v->entry < list->indexedFrom))
+        continue;
+      if (print)
+        showVisitor(v);
+      found++;
     }
   }
-  return 1;
+
+  /* on-site visits are filed only under their check-in hour */
+  for (int i = 0; i < index->onSiteCount; i++)
+  {
+    Visitor *v = &list->visitors[index->onSite[i]];
+    if (visitHour(v->entry) >= first || v->entry > to || now < from)
+      continue;
+    if (print)
+      showVisitor(v);
+    found++;
+  }
+  return found;
 }
 
-void getCurrentTime(char *timeStr)
+/*
+ * The closed visits from before indexedFrom that overlap [from, to]. With
+ * keep, they are also gathered into *keep (freed by the caller), so a
+ * caller asking about several parts of the window reads each segment once.
+ */
+int loggedVisitsBetween(VisitorList *list, int64_t from, int64_t to, int print, Visitor **keep)
 {
-  time_t now = time(NULL);
-  struct tm *local = localtime(&now);
-  strftime(timeStr, 20, "%Y-%m-%d %H:%M:%S", local);
+  VisitorLog *log = &list->log;
+  int found = 0;
+  for (int r = 0; r < log->dayCount; r++)
+  {
+    LogDay *d = &log->days[r];
+    int64_t start = dayStart(d->day, 0);
+    if (start >= list->indexedFrom || start > to)
+      break; /* rows are sorted by day */
+    if (d->lastExit < from)
+      continue; /* everyone from that day had left before the window */
+
+    Visitor *visits;
+    int count;
+    if (readSegment(d->day, &visits, &count) != 0)
+    {
+      printf(" Could not read the visits of %d.\n", d->day);
+      continue;
+    }
+    for (int i = 0; i < count; i++)
+    {
+      Visitor *v = &visits[i];
+      if (v->exit == 0 || v->entry > to || v->exit < from)
+        continue;
+      if (print)
+        showVisitor(v);
+      if (keep && (found == 0 || (found >= 16 && (found & (found - 1)) == 0)))
+      {
+        Visitor *grown = (Visitor *)realloc(*keep, sizeof(Visitor) * (found ? found * 2 : 16));
+        if (!grown)
+        {
+          free(visits);
+          printf(" Memory allocation failed; logged visits are left out.\n");
+          return found;
+        }
+        *keep = grown;
+      }
+      if (keep)
+        (*keep)[found] = *v;
+      found++;
+    }
+    free(visits);
+  }
+  return found;
 }
 
-// Output-- VISITOR MANAGEMENT SYSTEM
+void showVisitsBetween(VisitorList *list)
+{
+  char text[INPUT_LEN];
+  printf("\nTimes look like 2026-01-14, 2026-01-14 09:55 or 2026-01-14 09:55:01\n");
+  readText("From: ", text, sizeof(text));
+  int64_t from = timestampParse(text, 0);
+  readText("To: ", text, sizeof(text));
+  int64_t to = timestampParse(text, 1);
+  if (from < 0 || to < 0 || to < from)
+  {
+    printf(" Invalid time range!\n");
+    return;
+  }
+
+  printf("\n=== VISITORS BETWEEN ===\n");
+  int found = visitsBetween(list, from, to, 1);
+  printf("Total: %d\n", found);
+}
+
+void showOccupancy(VisitorList *list)
+{
+  char text[INPUT_LEN];
+  int counts[24];
+  readText("\nDate (YYYY-MM-DD): ", text, sizeof(text));
+  if (timestampParse(text, 0) < 0 || !occupancyOf(list, text, counts))
+  {
+    printf(" Invalid date!\n");
+    return;
+  }
+
+  printf("\n=== OCCUPANCY FOR %s ===\n", text);
+  printf("%-5s | %s\n", "HOUR", "VISITORS");
+  for (int hour = 0; hour < 24; hour++)
+    printf("%02d:00 | %d\n", hour, counts[hour]);
+}
 
 /*
-No existing data found. Starting fresh.
+ * Visitors on site in each hour of the day date starts with. The day's
+ * segments are read once, then counted hour by hour. Returns 0 for a bad date.
+ */
+int occupancyOf(VisitorList *list, const char *date, int counts[24])
+{
+  char at[INPUT_LEN + 8];
+  snprintf(at, sizeof(at), "%.10s", date);
+  int64_t dayFrom = timestampParse(at, 0), dayTo = timestampParse(at, 1);
+  if (dayFrom < 0 || dayTo < 0)
+    return 0;
+  keepIndexWindow(list);
+  Visitor *logged = NULL;
+  int loggedCount = loggedVisitsBetween(list, dayFrom, dayTo, 0, &logged);
 
-=== VISITOR MANAGEMENT SYSTEM ===
-==================================
+  for (int hour = 0; hour < 24; hour++)
+  {
+    /* parsing each hour keeps DST days right: they are not 24 x 3600 s */
+    snprintf(at, sizeof(at), "%.10s %02d:00", date, hour);
+    int64_t start = timestampParse(at, 0);
+    snprintf(at, sizeof(at), "%.10s %02d:59:59", date, hour);
+    int64_t end = timestampParse(at, 0);
+    counts[hour] = 0;
+    if (start < 0 || end < 0)
+      continue; /* an hour skipped by a DST change has no visitors */
+    for (int i = 0; i < loggedCount; i++)
+      counts[hour] += logged[i].entry <= end && logged[i].exit >= start;
+    counts[hour] += indexedVisitsBetween(list, start, end, 0);
+  }
+  free(logged);
+  return 1;
+}
 
-=========== MENU ===========
-1. Add New Visitor
-2. View All Visitors
-3. Save Data to file
-4. Exit
-============================
-Enter your choice (1-4): 1
+//====================Visitor Log====================
 
---- Add New Visitor ---
-Enter visitor name: Kureshu pujari
-Enter phone number: 7893285837
+/* Local calendar day of when as YYYYMMDD */
+int32_t dayOf(int64_t when)
+{
+  struct tm local;
+  time_t t = (time_t)when;
+  if (localtime_r(&t, &local) == NULL)
+    return 0;
+  return (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+}
+
+/* Local midnight starting day plus plusDays days */
+int64_t dayStart(int32_t day, int plusDays)
+{
+  struct tm t;
+  memset(&t, 0, sizeof(t));
+  t.tm_year = day / 10000 - 1900;
+  t.tm_mon = day / 100 % 100 - 1;
+  t.tm_mday = day % 100 + plusDays;
+  t.tm_isdst = -1;
+  return (int64_t)mktime(&t);
+}
 
- Visitor added successfully!
+void segmentPath(int32_t day, char *path)
+{
+  snprintf(path, PATH_LEN, LOG_DIR "/%04d-%02d-%02d.seg", day / 10000, day / 100 % 100,
+           day % 100);
+}
 
-=========== MENU ===========
-1. Add New Visitor
-2. View All Visitors
-3. Save Data to file
-4. Exit
-============================
-Enter your choice (1-4): 1
+/* Opens day's segment for appending, first cutting off a torn last record */
+FILE *openSegment(int32_t day)
+{
+  char path[PATH_LEN];
+  segmentPath(day, path);
+  struct stat st;
+  if (stat(path, &st) == 0 && st.st_size % sizeof(LogRecord) != 0 &&
+      truncate(path, st.st_size - st.st_size % sizeof(LogRecord)) != 0)
+    return NULL;
+  return fopen(path, "ab");
+}
 
---- Add New Visitor ---
-Enter visitor name: Kalyni Kumari
-Enter phone number: 7943258384
+/* All visits checked in on day, with their check-outs applied; 0 on success */
+int readSegment(int32_t day, Visitor **visits, int *count)
+{
+  char path[PATH_LEN];
+  segmentPath(day, path);
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return -1;
 
- Visitor added successfully!
+  long size = streamFileSize(file, 0);
+  int records = size > 0 ? (int)(size / sizeof(LogRecord)) : 0;
+  Visitor *out = (Visitor *)malloc((records ? records : 1) * sizeof(Visitor));
+  LogRecord *chunk = (LogRecord *)malloc(LOAD_CHUNK * sizeof(LogRecord));
+  if (out == NULL || chunk == NULL)
+  {
+    free(out);
+    free(chunk);
+    fclose(file);
+    return -1;
+  }
 
-=========== MENU ===========
-1. Add New Visitor
-2. View All Visitors
-3. Save Data to file
-4. Exit
-============================
-Enter your choice (1-4): 1
+  StreamLoad progress;
+  streamBegin(&progress, path, (uint64_t)records * sizeof(LogRecord));
+  int n = 0;
+  for (int done = 0; done < records;)
+  {
+    int batch = records - done < LOAD_CHUNK ? records - done : LOAD_CHUNK;
+    if (streamRead(file, chunk, (uint64_t)batch * sizeof(LogRecord), &progress) != 0)
+      break;
+    for (int i = 0; i < batch; i++)
+    {
+      Visitor *v = &chunk[i].visitor;
+      if (memcmp(chunk[i].kind, RECORD_IN, 4) == 0)
+      {
+        out[n] = *v;
+        out[n].name[MAX_NAME_LEN - 1] = '\0';
+        out[n].phone[MAX_PHONE_LEN - 1] = '\0';
+        n++;
+        continue;
+      }
+      if (memcmp(chunk[i].kind, RECORD_OUT, 4) != 0)
+        continue;
 
---- Add New Visitor ---
-Enter visitor name: Pravanjan Khutia
-Enter phone number: 7943253290
+      /* ids rise through a segment, so the visit is found by bisection */
+      int lo = 0, hi = n;
+      while (lo < hi)
+      {
+        int mid = (lo + hi) / 2;
+        if (out[mid].id < v->id)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      if (lo < n && out[lo].id == v->id)
+        out[lo].exit = v->exit;
+    }
+    done += batch;
+  }
+  streamEnd(&progress);
+  free(chunk);
+  fclose(file);
+
+  *visits = out;
+  *count = n;
+  return 0;
+}
 
- Visitor added successfully!
+/* Row of day in the manifest, adding an empty one if needed; -1 on failure */
+int logDay(VisitorLog *log, int32_t day, int *added)
+{
+  if (added)
+    *added = 0;
+  int lo = 0, hi = log->dayCount;
+  while (lo < hi)
+  {
+    int mid = (lo + hi) / 2;
+    if (log->days[mid].day < day)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < log->dayCount && log->days[lo].day == day)
+    return lo;
 
-=========== MENU ===========
-1. Add New Visitor
-2. View All Visitors
-3. Save Data to file
-4. Exit
-============================
-Enter your choice (1-4): 2
+  if (log->dayCount == log->dayCapacity)
+  {
+    int grown = log->dayCapacity ? log->dayCapacity * 2 : 32;
+    LogDay *temp = (LogDay *)realloc(log->days, grown * sizeof(LogDay));
+    if (temp == NULL)
+      return -1;
+    log->days = temp;
+    log->dayCapacity = grown;
+  }
+  memmove(&log->days[lo + 1], &log->days[lo], (log->dayCount - lo) * sizeof(LogDay));
+  memset(&log->days[lo], 0, sizeof(LogDay));
+  log->days[lo].day = day;
+  log->dayCount++;
+  if (added)
+    *added = 1;
+  return lo;
+}
 
-=== VISITOR REGISTER (Total: 3) ===
-ID   | NAME                 | PHONE           | VISIT TIME
-----------------------------------------------------------
-1    | Kureshu pujari       | 7893285837      | 2026-01-13 22:42:36
-2    | Kalyni Kumari        | 7943258384      | 2026-01-13 22:43:08
-3    | Pravanjan Khutia     | 7943253290      | 2026-01-13 22:43:38
+/* Folds one record of v into the manifest row */
+void countVisit(VisitorLog *log, int row, const Visitor *v)
+{
+  LogDay *d = &log->days[row];
+  if (v->exit > d->lastExit)
+    d->lastExit = v->exit;
+  if (v->id >= log->nextId)
+    log->nextId = v->id + 1;
+}
 
-=========== MENU ===========
-1. Add New Visitor
-2. View All Visitors
-3. Save Data
-4. Exit
-============================
-Enter your choice (1-4): 3
+/*
+ * Appends a check-in or check-out of v to the segment of its check-in day,
+ * then patches that day's manifest row in place. Check-ins go to the
+ * segment kept open for today; a check-out of an earlier day's visit opens
+ * that day's segment just for the one record.
+ *
+ * The segment record is what makes the change stick. A record that could
+ * not be written whole is cut off again, so a failed check-in or check-out
+ * leaves nothing behind. A manifest that could not be updated afterwards is
+ * only behind, and openVisitorLog brings it back in line from the segments
+ * at the next start.
+ */
+int appendVisit(VisitorLog *log, const Visitor *v, int checkIn)
+{
+  int32_t day = dayOf(v->entry);
+  int added;
+  int row = logDay(log, day, &added);
+  if (row < 0)
+    return 0;
 
- Data saved successfully!
+  FILE *file = log->segment;
+  if (day != log->segmentDay)
+  {
+    file = openSegment(day);
+    if (file == NULL)
+      return 0;
+    if (checkIn)
+    {
+      if (log->segment)
+        fclose(log->segment);
+      log->segment = file;
+      log->segmentDay = day;
+    }
+  }
 
-=========== MENU ===========
-1. Add New Visitor
-2. View All Visitors
-3. Save Data to file
+  LogRecord record;
+  memset(&record, 0, sizeof(record));
+  memcpy(record.kind, checkIn ? RECORD_IN : RECORD_OUT, 4);
+  record.visitor = *v;
+  struct stat st;
+  int sized = fstat(fileno(file), &st) == 0;
+  int ok = sized && fwrite(&record, sizeof(record), 1, file) == 1 && fflush(file) == 0;
+  if (!ok)
+  {
+    /* the stream may still hold part of the record; reopen it fresh next time */
+    if (file == log->segment)
+    {
+      log->segment = NULL;
+      log->segmentDay = -1;
+    }
+    fclose(file);
+    char path[PATH_LEN];
+    segmentPath(day, path);
+    if (sized && truncate(path, st.st_size) != 0)
+      printf(" Could not trim a torn record from %s.\n", path);
+    return 0;
+  }
+  if (file != log->segment)
+    fclose(file);
+
+  LogDay *d = &log->days[row];
+  if (checkIn)
+  {
+    d->count++;
+    d->open += v->exit == 0;
+  }
+  else if (d->open > 0)
+  {
+    d->open--;
+  }
+  countVisit(log, row, v);
+
+  /* a day arriving out of order shifts the rows after it */
+  int saved;
+  if (log->manifestStale || (added && row != log->dayCount - 1))
+    saved = rewriteManifest(log);
+  else
+    saved = writeManifestRow(log, row) && (!(checkIn || added) || writeManifestHeader(log));
+  if (!saved && !log->manifestStale)
+    printf(" Could not update %s; it is repaired at the next start.\n", MANIFEST_FILENAME);
+  log->manifestStale = !saved;
+  return 1;
+}
+
+/*
+ * Bulk form of appendVisit for moving visitors.dat into the log: each run of
+ * visits from the same day becomes one write. The caller rewrites the
+ * manifest afterwards.
+ */
+int appendRuns(VisitorLog *log, const Visitor *visits, int count)
+{
+  LogRecord *records = (LogRecord *)calloc(LOAD_CHUNK, sizeof(LogRecord));
+  if (records == NULL)
+    return 0;
+
+  int i = 0;
+  while (i < count)
+  {
+    int32_t day = dayOf(visits[i].entry);
+    int64_t start = dayStart(day, 0), end = dayStart(day, 1);
+    int n = 0;
+    while (i + n < count && n < LOAD_CHUNK && visits[i + n].entry >= start &&
+           visits[i + n].entry < end)
+      n++;
+    if (n == 0)
+      n = 1; /* a time localtime cannot place still gets a day */
+
+    int row = logDay(log, day, NULL);
+    FILE *file = row < 0 ? NULL : openSegment(day);
+    if (file == NULL)
+      break;
+    for (int k = 0; k < n; k++)
+    {
+      memcpy(records[k].kind, RECORD_IN, 4);
+      records[k].visitor = visits[i + k];
+      log->days[row].count++;
+      log->days[row].open += visits[i + k].exit == 0;
+      countVisit(log, row, &visits[i + k]);
+    }
+    int ok = fwrite(records, sizeof(LogRecord), n, file) == (size_t)n;
+    if (fclose(file) != 0 || !ok)
+      break;
+    i += n;
+  }
+  free(records);
+  return i == count;
+}
+
+int writeManifestHeader(VisitorLog *log)
+{
+  ManifestHeader header = {{0}, LOG_VERSION, log->dayCount, 0, log->nextId};
+  memcpy(header.magic, MANIFEST_MAGIC, 4);
+  return fseek(log->manifest, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(header), 1, log->manifest) == 1 && fflush(log->manifest) == 0;
+}
+
+int writeManifestRow(VisitorLog *log, int row)
+{
+  long offset = (long)sizeof(ManifestHeader) + (long)row * (long)sizeof(LogDay);
+  return fseek(log->manifest, offset, SEEK_SET) == 0 &&
+         fwrite(&log->days[row], sizeof(LogDay), 1, log->manifest) == 1 &&
+         fflush(log->manifest) == 0;
+}
+
+/* Writes the whole manifest to a new file and renames it over the old one */
+int rewriteManifest(VisitorLog *log)
+{
+  FILE *old = log->manifest;
+  log->manifest = fopen(MANIFEST_FILENAME ".tmp", "w+b");
+  if (log->manifest == NULL)
+  {
+    log->manifest = old;
+    return 0;
+  }
+  int ok = writeManifestHeader(log) &&
+           (log->dayCount == 0 ||
+            fwrite(log->days, sizeof(LogDay), log->dayCount, log->manifest) ==
+                (size_t)log->dayCount) &&
+           fflush(log->manifest) == 0 && rename(MANIFEST_FILENAME ".tmp", MANIFEST_FILENAME) == 0;
+  if (!ok)
+  {
+    fclose(log->manifest);
+    remove(MANIFEST_FILENAME ".tmp");
+    log->manifest = old;
+    return 0;
+  }
+  if (old)
+    fclose(old);
+  return 1;
+}
+
+/* Loads the manifest rows; 0 if it is missing or damaged */
+int readManifest(VisitorLog *log)
+{
+  FILE *file = fopen(MANIFEST_FILENAME, "r+b");
+  if (!file)
+    return 0;
+
+  ManifestHeader header;
+  long size = streamFileSize(file, 0);
+  if (size < (long)sizeof(header) || fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, MANIFEST_MAGIC, 4) != 0 || header.version != LOG_VERSION ||
+      header.dayCount < 0 ||
+      (size_t)(size - sizeof(header)) / sizeof(LogDay) < (size_t)header.dayCount)
+  {
+    printf(" %s is damaged. Rebuilding it from the day files.\n", MANIFEST_FILENAME);
+    fclose(file);
+    return 0;
+  }
+
+  log->days = (LogDay *)malloc((header.dayCount ? header.dayCount : 1) * sizeof(LogDay));
+  if (log->days == NULL ||
+      fread(log->days, sizeof(LogDay), header.dayCount, file) != (size_t)header.dayCount)
+  {
+    printf(" %s could not be read. Rebuilding it from the day files.\n", MANIFEST_FILENAME);
+    free(log->days);
+    log->days = NULL;
+    fclose(file);
+    return 0;
+  }
+  log->dayCount = log->dayCapacity = header.dayCount;
+  log->nextId = header.nextId > 0 ? header.nextId : 1;
+  log->manifest = file;
+  return 1;
+}
+
+/*
+ * Adds a row for each segment file on disk the manifest does not list yet,
+ * counted from the file. Returns how many rows were added.
+ */
+int rebuildManifest(VisitorLog *log)
+{
+  DIR *dir = opendir(LOG_DIR);
+  if (!dir)
+    return 0;
+
+  int added = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL)
+  {
+    int year, month, date, length = 0;
+    if (sscanf(entry->d_name, "%4d-%2d-%2d.seg%n", &year, &month, &date, &length) != 3 ||
+        length == 0 || entry->d_name[length] != '\0')
+      continue;
+
+    int32_t day = year * 10000 + month * 100 + date;
+    Visitor *visits;
+    int count, isNew;
+    int row = logDay(log, day, &isNew);
+    if (row < 0 || !isNew)
+      continue;
+    added++;
+    if (readSegment(day, &visits, &count) != 0)
+      continue;
+    for (int i = 0; i < count; i++)
+    {
+      log->days[row].count++;
+      log->days[row].open += visits[i].exit == 0;
+      countVisit(log, row, &visits[i]);
+    }
+    free(visits);
+  }
+  closedir(dir);
+  return added;
+}
+
+int openVisitorLog(VisitorList *list)
+{
+  VisitorLog *log = &list->log;
+  if (mkdir(LOG_DIR, 0755) != 0 && errno != EEXIST)
+  {
+    printf(" Cannot create %s/. Exiting.\n", LOG_DIR);
+    return 0;
+  }
+
+  if (!readManifest(log))
+  {
+    rebuildManifest(log);
+    if (log->dayCount == 0 && migrateOldFile(list) < 0)
+    {
+      printf(" Cannot move %s into %s/. Exiting.\n", FILENAME, LOG_DIR);
+      return 0;
+    }
+    if (!rewriteManifest(log))
+    {
+      printf(" Cannot write %s. Exiting.\n", MANIFEST_FILENAME);
+      return 0;
+    }
+  }
+  /* days whose first check-in never reached the manifest */
+  else if (rebuildManifest(log) > 0)
+  {
+    log->manifestStale = 1;
+  }
+
+  loadRecentVisits(list);
+  return 1;
+}
+
+/*
+ * Loads the days from indexedFrom on in full, and only the visitors still
+ * on site from older days. Rows that were read get their counts refreshed,
+ * which also repairs a manifest left behind by a crash mid-append.
+ */
+void loadRecentVisits(VisitorList *list)
+{
+  VisitorLog *log = &list->log;
+  list->indexedFrom = dayStart(dayOf(timestampNow()), 1 - LOG_RECENT_DAYS);
+  if (log->dayCount == 0)
+  {
+    printf(" No existing data found. Starting fresh.\n");
+    return;
+  }
+
+  int days = 0;
+  for (int r = 0; r < log->dayCount; r++)
+  {
+    LogDay *d = &log->days[r];
+    int recent = dayStart(d->day, 0) >= list->indexedFrom;
+    if (!recent && d->open == 0)
+      continue;
+
+    Visitor *visits;
+    int count;
+    if (readSegment(d->day, &visits, &count) != 0)
+    {
+      printf(" Could not read the visits of %d.\n", d->day);
+      continue;
+    }
+
+    LogDay seen = {d->day, count, 0, 0, 0};
+    for (int i = 0; i < count; i++)
+    {
+      seen.open += visits[i].exit == 0;
+      if (visits[i].exit > seen.lastExit)
+        seen.lastExit = visits[i].exit;
+      if (visits[i].id >= log->nextId)
+        log->nextId = visits[i].id + 1;
+      if (!recent && visits[i].exit != 0)
+        continue;
+      if (!reserveVisitors(list, list->count + 1))
+        break;
+      list->visitors[list->count] = visits[i];
+      indexVisit(list, list->count++);
+    }
+    free(visits);
+    days++;
+
+    if (memcmp(&seen, d, sizeof(seen)) != 0)
+    {
+      *d = seen;
+      if (!log->manifestStale)
+        writeManifestRow(log, r);
+    }
+  }
+  if (log->manifestStale)
+    log->manifestStale = !rewriteManifest(log);
+  else
+    writeManifestHeader(log);
+  keepIndexWindow(list);
+  printf(" Loaded %d visitors from %d of %d days on file.\n", list->count, days, log->dayCount);
+}
+
+/* Pushes appended records through to the disk */
+void syncVisitorLog(VisitorLog *log)
+{
+  if (log->segment)
+  {
+    fflush(log->segment);
+    fsync(fileno(log->segment));
+  }
+  if (log->manifest)
+  {
+    fflush(log->manifest);
+    fsync(fileno(log->manifest));
+  }
+}
+
+/* Deletes the segments of days before a date, except days with visitors on site */
+void pruneVisitorLog(VisitorList *list)
+{
+  VisitorLog *log = &list->log;
+  char text[INPUT_LEN];
+  readText("\nRemove visits checked in before (YYYY-MM-DD): ", text, sizeof(text));
+  int64_t before = timestampParse(text, 0);
+  if (before < 0)
+  {
+    printf(" Invalid date!\n");
+    return;
+  }
+
+  int32_t beforeDay = dayOf(before);
+  int kept = 0, days = 0, busy = 0;
+  long long visits = 0;
+  for (int r = 0; r < log->dayCount; r++)
+  {
+    LogDay *d = &log->days[r];
+    if (d->day >= beforeDay || d->open > 0)
+    {
+      busy += d->day < beforeDay;
+      log->days[kept++] = *d;
+      continue;
+    }
+
+    char path[PATH_LEN];
+    segmentPath(d->day, path);
+    if (d->day == log->segmentDay)
+    {
+      fclose(log->segment);
+      log->segment = NULL;
+      log->segmentDay = -1;
+    }
+    if (remove(path) != 0 && errno != ENOENT)
+    {
+      printf(" Could not remove %s.\n", path);
+      log->days[kept++] = *d;
+      continue;
+    }
+    days++;
+    visits += d->count;
+  }
+  log->dayCount = kept;
+  log->manifestStale = !rewriteManifest(log);
+  if (log->manifestStale)
+    printf(" Failed to save data!\n");
+
+  /* what is left before the date is only read from disk now */
+  if (before > list->indexedFrom)
+    list->indexedFrom = before;
+
+  printf("\n Removed %lld visits over %d days.\n", visits, days);
+  if (busy > 0)
+    printf(" Kept %d earlier days that still have visitors on site.\n", busy);
+}
+
+/*
+ * Moves an old single-file visitors.dat into the log, numbering the visits
+ * in file order, and keeps the old file as visitors.dat.old. Returns 1 once
+ * moved, 0 if there was nothing to move and -1 if the move failed; a failed
+ * move leaves no segments behind, so the next start tries it again.
+ */
+int migrateOldFile(VisitorList *list)
+{
+  FILE *file = fopen(FILENAME, "rb");
+  if (!file)
+    return 0;
+
+  VisitorFileHeader header;
+  long size = streamFileSize(file, 0);
+  int loaded = 0;
+  if (size < (long)sizeof(int) || fread(&header, 1, sizeof(int), file) != sizeof(int))
+    printf(" %s is damaged. Starting fresh.\n", FILENAME);
+  else if (memcmp(header.magic, FILE_MAGIC, 4) == 0)
+    loaded = loadStored(list, file, size);
+  else
+    loaded = loadLegacy(list, file, size);
+  fclose(file);
+  if (!loaded)
+    return 0;
+
+  VisitorLog *log = &list->log;
+  for (int i = 0; i < list->count; i++)
+    list->visitors[i].id = i + 1;
+  int moved = list->count;
+  list->count = 0; /* loadRecentVisits reads them back from the log */
+  if (!appendRuns(log, list->visitors, moved))
+  {
+    /* the log was empty before, so every segment is from this attempt */
+    for (int r = 0; r < log->dayCount; r++)
+    {
+      char path[PATH_LEN];
+      segmentPath(log->days[r].day, path);
+      remove(path);
+    }
+    log->dayCount = 0;
+    log->nextId = 1;
+    return -1;
+  }
+
+  /* the segments hold every visit now; a rebuild finds them without the old file */
+  if (rename(FILENAME, FILENAME ".old") == 0)
+    printf(" Moved %d visitors from %s into %s/.\n", moved, FILENAME, LOG_DIR);
+  else
+    printf(" Moved %d visitors into %s/ but could not rename %s.\n", moved, LOG_DIR, FILENAME);
+  return 1;
+}
+
+/* Grows the array to at least count visitors; 0 if memory ran out */
+int reserveVisitors(VisitorList *list, int count)
+{
+  if (count <= list->capacity)
+    return 1;
+  int grown = list->capacity * 2 > count ? list->capacity * 2 : count;
+  Visitor *temp = (Visitor *)realloc(list->visitors, grown * sizeof(Visitor));
+  if (temp == NULL)
+  {
+    printf(" Not enough memory for %d visitors.\n", count);
+    return 0;
+  }
+  list->visitors = temp;
+  list->capacity = grown;
+  return 1;
+}
+
+/* visitors.dat version 2: the header, then binary entry and exit times */
+int loadStored(VisitorList *list, FILE *file, long size)
+{
+  VisitorFileHeader header;
+  fseek(file, 0, SEEK_SET);
+  if (size < (long)sizeof(header) || fread(&header, sizeof(header), 1, file) != 1 ||
+      header.version != FILE_VERSION || header.count < 0 ||
+      (size_t)(size - sizeof(header)) / sizeof(StoredVisitor) < (size_t)header.count)
+  {
+    printf(" %s is damaged. Starting fresh.\n", FILENAME);
+    return 0;
+  }
+
+  int count = header.count;
+  StoredVisitor *chunk = (StoredVisitor *)malloc(LOAD_CHUNK * sizeof(StoredVisitor));
+  if (chunk == NULL || !reserveVisitors(list, count))
+  {
+    free(chunk);
+    return 0;
+  }
+
+  StreamLoad progress;
+  streamBegin(&progress, FILENAME, (uint64_t)count * sizeof(StoredVisitor));
+  int loaded = 0;
+  while (loaded < count)
+  {
+    int n = count - loaded < LOAD_CHUNK ? count - loaded : LOAD_CHUNK;
+    if (streamRead(file, chunk, (uint64_t)n * sizeof(StoredVisitor), &progress) != 0)
+      break;
+    for (int i = 0; i < n; i++)
+    {
+      Visitor *v = &list->visitors[loaded + i];
+      memcpy(v->name, chunk[i].name, MAX_NAME_LEN);
+      memcpy(v->phone, chunk[i].phone, MAX_PHONE_LEN);
+      v->name[MAX_NAME_LEN - 1] = '\0';
+      v->phone[MAX_PHONE_LEN - 1] = '\0';
+      v->entry = chunk[i].entry;
+      v->exit = chunk[i].exit;
+    }
+    loaded += n;
+  }
+  streamEnd(&progress);
+  free(chunk);
+
+  list->count = loaded;
+  if (loaded < count)
+    printf(" %s ended early; kept the first %d visitors.\n", FILENAME, loaded);
+  return 1;
+}
+
+/*
+ * visitors.dat version 1: an int count, then records with the visit time as
+ * text. They never recorded a departure, so each old visit is closed at its
+ * own check-in time rather than left on site forever.
+ */
+int loadLegacy(VisitorList *list, FILE *file, long size)
+{
+  int count;
+  fseek(file, 0, SEEK_SET);
+  if (fread(&count, sizeof(int), 1, file) != 1 || count < 0 ||
+      (size_t)(size - sizeof(int)) / sizeof(LegacyVisitor) < (size_t)count)
+  {
+    printf(" %s is damaged. Starting fresh.\n", FILENAME);
+    return 0;
+  }
+
+  LegacyVisitor *chunk = (LegacyVisitor *)malloc(LOAD_CHUNK * sizeof(LegacyVisitor));
+  if (chunk == NULL || !reserveVisitors(list, count))
+  {
+    free(chunk);
+    return 0;
+  }
+
+  StreamLoad progress;
+  streamBegin(&progress, FILENAME, (uint64_t)count * sizeof(LegacyVisitor));
+  int loaded = 0;
+  while (loaded < count)
+  {
+    int n = count - loaded < LOAD_CHUNK ? count - loaded : LOAD_CHUNK;
+    if (streamRead(file, chunk, (uint64_t)n * sizeof(LegacyVisitor), &progress) != 0)
+      break;
+    for (int i = 0; i < n; i++)
+    {
+      Visitor *v = &list->visitors[loaded + i];
+      memcpy(v->name, chunk[i].name, MAX_NAME_LEN);
+      memcpy(v->phone, chunk[i].phone, MAX_PHONE_LEN);
+      v->name[MAX_NAME_LEN - 1] = '\0';
+      v->phone[MAX_PHONE_LEN - 1] = '\0';
+      chunk[i].visit_time[TIMESTAMP_LEN - 1] = '\0';
+      int64_t at = timestampParse(chunk[i].visit_time, 0);
+      v->entry = at > 0 ? at : 0;
+      v->exit = v->entry > 0 ? v->entry : 1;
+    }
+    loaded += n;
+  }
+  streamEnd(&progress);
+  free(chunk);
+
+  list->count = loaded;
+  if (loaded < count)
+    printf(" %s ended early; kept the first %d visitors.\n", FILENAME, loaded);
+  return 1;
+}
+
+int readText(const char *prompt, char *text, int size)
+{
+  printf("%s", prompt);
+  if (fgets(text, size, stdin) == NULL)
+  {
+    text[0] = '\0';
+    return 0;
+  }
+  text[strcspn(text, "\n")] = 0;
+  return 1;
+}
+
+void displayMenu()
+{
+  printf("\n=========== MENU ===========\n");
+  printf("1. Check In Visitor\n");
+  printf("2. View All Visitors\n");
+  printf("3. Save Data \n");
+  printf("4. Exit\n");
+  printf("5. Check Out Visitor\n");
+  printf("6. Who Is On Site Now\n");
+  printf("7. Visitors Between Times\n");
+  printf("8. Occupancy Per Hour\n");
+  printf("9. Remove Old Visits\n");
+  printf("============================\n");
+  printf("Enter your choice (1-9): ");
+}
+
+int getValidChoice()
+{
+  int choice;
+  while (scanf("%d", &choice) != 1 || choice < 1 || choice > 9)
+  {
+    printf("Please enter a number between 1-9: ");
+    clearInputBuffer();
+  }
+  clearInputBuffer();
+  return choice;
+}
+
+void clearInputBuffer()
+{
+  int c;
+  while ((c = getchar()) != '\n')
+    ;
+}
+
+int isValidPhone(const char *phone)
+{
+  return phoneIsDialable(phone);
+}
+
+//====================Self Check====================
+void expect(CheckRun *run, int ok, const char *what)
+{
+  if (ok)
+    run->passed++;
+  else
+    run->failed++;
+  printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+}
+
+/* xorshift32, so every run of the check sees the same visits */
+uint32_t checkRandom(uint32_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+Visitor checkVisitor(int64_t id, int64_t entry, int64_t exit)
+{
+  Visitor v;
+  memset(&v, 0, sizeof(v));
+  snprintf(v.name, MAX_NAME_LEN, "Check %lld", (long long)id);
+  strcpy(v.phone, "5550000000");
+  v.id = id;
+  v.entry = entry;
+  v.exit = exit;
+  return v;
+}
+
+int fileExists(const char *path)
+{
+  struct stat st;
+  return stat(path, &st) == 0;
+}
+
+void removeLogFiles(void)
+{
+  DIR *dir = opendir(LOG_DIR);
+  if (dir)
+  {
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+      char path[PATH_LEN + 256];
+      snprintf(path, sizeof(path), LOG_DIR "/%s", entry->d_name);
+      if (entry->d_name[0] != '.')
+        remove(path);
+    }
+    closedir(dir);
+    rmdir(LOG_DIR);
+  }
+  remove(FILENAME);
+  remove(FILENAME ".old");
+}
+
+/* Drops everything in memory and opens the log the way startup does */
+int reopenVisitors(VisitorList *list)
+{
+  freeVisitorList(list);
+  initVisitorList(list);
+  return openVisitorLog(list);
+}
+
+/* What visitsBetween must answer, by looking at every visit */
+int scanVisitsBetween(const Visitor *all, int count, int64_t from, int64_t to, int64_t now)
+{
+  int found = 0;
+  for (int i = 0; i < count; i++)
+  {
+    int64_t left = all[i].exit != 0 ? all[i].exit : now;
+    found += all[i].entry <= to && left >= from;
+  }
+  return found;
+}
+
+/*
+ * Compares visitsBetween with a full scan over random windows, and windows
+ * starting on and just after indexedFrom, where memory hands over to disk.
+ */
+int windowMismatches(VisitorList *list, const Visitor *all, int count, uint32_t *state)
+{
+  int64_t now = timestampNow();
+  int mismatches = 0;
+  for (int w = 0; w < CHECK_WINDOWS; w++)
+  {
+    int64_t from, to;
+    if (w < 48)
+    {
+      from = list->indexedFrom + (int64_t)w * 3600;
+      to = from + (w % 2 ? 3600 : 86400);
+    }
+    else
+    {
+      from = now - checkRandom(state) % ((CHECK_DAYS + 2) * 86400);
+      to = from + checkRandom(state) % (5 * 86400);
+    }
+    if (visitsBetween(list, from, to, 0) != scanVisitsBetween(all, count, from, to, now))
+      mismatches++;
+  }
+  return mismatches;
+}
+
+/* Hours of the day holding when where occupancyOf and visitsBetween disagree */
+int occupancyMismatches(VisitorList *list, int64_t when)
+{
+  char date[TIMESTAMP_LEN], at[TIMESTAMP_LEN + 8];
+  int counts[24], mismatches = 0;
+  timestampText(when, date);
+  if (!occupancyOf(list, date, counts))
+    return 24;
+  for (int hour = 0; hour < 24; hour++)
+  {
+    snprintf(at, sizeof(at), "%.10s %02d:00", date, hour);
+    int64_t start = timestampParse(at, 0);
+    snprintf(at, sizeof(at), "%.10s %02d:59:59", date, hour);
+    int64_t end = timestampParse(at, 0);
+    if (start >= 0 && end >= 0 && counts[hour] != visitsBetween(list, start, end, 0))
+      mismatches++;
+  }
+  return mismatches;
+}
+
+void checkWindowQueries(CheckRun *run)
+{
+  VisitorList list;
+  removeLogFiles();
+  initVisitorList(&list);
+  openVisitorLog(&list);
+
+  /* visits over CHECK_DAYS days, some staying for days and some still on site */
+  uint32_t state = 2463534242u;
+  int64_t now = timestampNow();
+  Visitor all[CHECK_VISITS];
+  for (int i = 0; i < CHECK_VISITS; i++)
+  {
+    int64_t entry = now - 1 - checkRandom(&state) % (CHECK_DAYS * 86400);
+    int64_t stay = checkRandom(&state) % 4 == 0 ? checkRandom(&state) % (20 * 86400)
+                                                 : checkRandom(&state) % (8 * 3600);
+    int64_t exit = entry + stay < now ? entry + stay : now;
+    all[i] = checkVisitor(0, entry, checkRandom(&state) % 10 == 0 ? 0 : exit);
+  }
+  /* one visit that is sure to check in before indexedFrom and leave after it */
+  all[0].entry = list.indexedFrom - 2 * 86400;
+  all[0].exit = list.indexedFrom + 3 * 86400;
+
+  /* check-ins in time order keep ids rising through every segment */
+  for (int i = 1; i < CHECK_VISITS; i++)
+  {
+    Visitor v = all[i];
+    int j = i;
+    for (; j > 0 && all[j - 1].entry > v.entry; j--)
+      all[j] = all[j - 1];
+    all[j] = v;
+  }
+  int saved = 1;
+  for (int i = 0; i < CHECK_VISITS; i++)
+  {
+    all[i].id = i + 1;
+    Visitor in = all[i];
+    in.exit = 0;
+    saved = appendVisit(&list.log, &in, 1) && saved;
+  }
+  for (int i = 0; i < CHECK_VISITS; i++)
+    if (all[i].exit != 0)
+      saved = appendVisit(&list.log, &all[i], 0) && saved;
+
+  int opened = reopenVisitors(&list);
+  int64_t from = list.indexedFrom + 86400;
+  expect(run, saved && opened && visitsBetween(&list, from, from + 3600, 0) ==
+                                     scanVisitsBetween(all, CHECK_VISITS, from, from + 3600, now),
+         "a visit from before indexedFrom counts in a window after it");
+  expect(run, windowMismatches(&list, all, CHECK_VISITS, &state) == 0,
+         "windows across the startup window match a full scan");
+
+  /* checking out visitors from before indexedFrom moves them to the segments */
+  int checkedOut = 0;
+  for (int i = 0; i < list.index.onSiteCount;)
+  {
+    Visitor *v = &list.visitors[list.index.onSite[i]];
+    if (v->entry >= list.indexedFrom)
+    {
+      i++;
+      continue;
+    }
+    if (!checkOutAt(&list, i))
+      break;
+    all[v->id - 1].exit = v->exit;
+    checkedOut++;
+  }
+  expect(run, checkedOut > 0 && windowMismatches(&list, all, CHECK_VISITS, &state) == 0,
+         "windows match after checking out visitors from before indexedFrom");
+  expect(run, reopenVisitors(&list) && windowMismatches(&list, all, CHECK_VISITS, &state) == 0,
+         "windows match after a restart");
+  expect(run, occupancyMismatches(&list, list.indexedFrom - 86400) == 0 &&
+                  occupancyMismatches(&list, list.indexedFrom) == 0,
+         "occupancy on either side of indexedFrom matches hourly windows");
+  freeVisitorList(&list);
+}
+
+void checkManifestRepair(CheckRun *run)
+{
+  VisitorList list;
+  removeLogFiles();
+  initVisitorList(&list);
+  openVisitorLog(&list);
+  int64_t now = timestampNow();
+  Visitor first = checkVisitor(1, now - 60, 0);
+  int saved = appendVisit(&list.log, &first, 1);
+
+  /* a read-only manifest and a directory where its rewrite goes make every update fail */
+  fclose(list.log.manifest);
+  list.log.manifest = fopen(MANIFEST_FILENAME, "rb");
+  mkdir(MANIFEST_FILENAME ".tmp", 0755);
+  Visitor earlier = checkVisitor(2, now - 3 * 86400, now - 3 * 86400 + 3600);
+  Visitor later = checkVisitor(3, now - 30, 0);
+  saved = appendVisit(&list.log, &earlier, 1) && saved;
+  saved = appendVisit(&list.log, &earlier, 0) && saved;
+  saved = appendVisit(&list.log, &later, 1) && saved;
+  expect(run, saved && list.log.manifestStale, "a visit in its segment counts as saved");
+
+  rmdir(MANIFEST_FILENAME ".tmp");
+  int opened = reopenVisitors(&list);
+  expect(run, opened && list.count == 3 && list.log.dayCount == 2 && list.log.nextId == 4 &&
+                  !list.log.manifestStale,
+         "the manifest catches up with the segments at the next start");
+  freeVisitorList(&list);
+}
+
+void checkTornRecords(CheckRun *run)
+{
+  VisitorList list;
+  removeLogFiles();
+  initVisitorList(&list);
+  openVisitorLog(&list);
+  int64_t now = timestampNow();
+  Visitor first = checkVisitor(1, now - 60, 0);
+  int saved = appendVisit(&list.log, &first, 1);
+  freeVisitorList(&list);
+
+  /* room for half a record more, so the next check-in and check-out are both torn */
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    struct rlimit limit = {sizeof(LogRecord) * 3 / 2, sizeof(LogRecord) * 3 / 2};
+    signal(SIGXFSZ, SIG_IGN);
+    initVisitorList(&list);
+    int ok = openVisitorLog(&list) && setrlimit(RLIMIT_FSIZE, &limit) == 0;
+    Visitor second = checkVisitor(2, now - 30, 0);
+    ok = ok && !appendVisit(&list.log, &second, 1) && list.log.segment == NULL &&
+         list.index.onSiteCount == 1 && !checkOutAt(&list, 0) &&
+         list.visitors[list.index.onSite[0]].exit == 0;
+    _exit(ok ? 0 : 1);
+  }
+  int status;
+  int failed = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+               WEXITSTATUS(status) == 0;
+  char path[PATH_LEN];
+  struct stat st;
+  segmentPath(dayOf(first.entry), path);
+  expect(run, saved && failed && stat(path, &st) == 0 && st.st_size == sizeof(LogRecord),
+         "failed writes leave no torn records in the segment");
+
+  initVisitorList(&list);
+  int opened = openVisitorLog(&list);
+  expect(run, opened && list.count == 1 && list.index.onSiteCount == 1,
+         "a failed check-out leaves the visitor on site");
+  freeVisitorList(&list);
+}
+
+void checkMigration(CheckRun *run)
+{
+  removeLogFiles();
+  int64_t now = timestampNow();
+  int64_t entries[] = {now - 40 * 86400, now - 10 * 86400, now - 10 * 86400 + 60,
+                       now - 10 * 86400 + 120, now - 5 * 86400, now - 5 * 86400 + 60};
+  int count = (int)(sizeof(entries) / sizeof(entries[0]));
+  FILE *file = fopen(FILENAME, "wb");
+  VisitorFileHeader header = {{0}, FILE_VERSION, count, 0};
+  memcpy(header.magic, FILE_MAGIC, 4);
+  int written = file && fwrite(&header, sizeof(header), 1, file) == 1;
+  for (int i = 0; written && i < count; i++)
+  {
+    StoredVisitor stored;
+    memset(&stored, 0, sizeof(stored));
+    snprintf(stored.name, MAX_NAME_LEN, "Moved %d", i + 1);
+    strcpy(stored.phone, "5550000000");
+    stored.entry = entries[i];
+    stored.exit = entries[i] + 600;
+    written = fwrite(&stored, sizeof(stored), 1, file) == 1;
+  }
+  if (file)
+    written = fclose(file) == 0 && written;
+
+  /* files over one record cannot be written, so the second day fails */
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    struct rlimit limit = {sizeof(LogRecord), sizeof(LogRecord)};
+    signal(SIGXFSZ, SIG_IGN);
+    VisitorList list;
+    initVisitorList(&list);
+    _exit(setrlimit(RLIMIT_FSIZE, &limit) == 0 && !openVisitorLog(&list) ? 0 : 1);
+  }
+  int status;
+  int refused = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+                WEXITSTATUS(status) == 0;
+  VisitorLog scratch;
+  memset(&scratch, 0, sizeof(scratch));
+  int segments = rebuildManifest(&scratch);
+  free(scratch.days);
+  expect(run, written && refused && segments == 0 && fileExists(FILENAME) &&
+                  !fileExists(MANIFEST_FILENAME),
+         "a failed move of visitors.dat leaves no log behind");
+
+  VisitorList list;
+  initVisitorList(&list);
+  int opened = openVisitorLog(&list);
+  long long total = 0;
+  for (int r = 0; r < list.log.dayCount; r++)
+    total += list.log.days[r].count;
+  expect(run, opened && total == count && list.log.nextId == count + 1 &&
+                  fileExists(FILENAME ".old"),
+         "the next start moves visitors.dat completely");
+  freeVisitorList(&list);
+}
+
+/*
+ * visitor_management_system check: runs each behaviour check against a
+ * fresh log in a scratch directory and prints PASS or FAIL per check.
+ */
+int runChecks(void)
+{
+  char dir[] = "/tmp/visitors-check-XXXXXX";
+  int home = open(".", O_RDONLY);
+  if (home == -1 || mkdtemp(dir) == NULL || chdir(dir) != 0)
+  {
+    printf("Failed to set up a scratch directory\n");
+    return 0;
+  }
+
+  CheckRun run = {0, 0};
+  checkWindowQueries(&run);
+  checkManifestRepair(&run);
+  checkTornRecords(&run);
+  checkMigration(&run);
+
+  removeLogFiles();
+  if (fchdir(home) != 0 || rmdir(dir) != 0)
+    printf("Failed to remove %s\n", dir);
+  close(home);
+  printf("%d passed, %d failed\n", run.passed, run.failed);
+  return run.failed == 0;
+}
+
+// Output-- VISITOR MANAGEMENT SYSTEM
+
+/*
+ No existing data found. Starting fresh.
+
+=== VISITOR MANAGEMENT SYSTEM ===
+==================================
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
+4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
+============================
+Enter your choice (1-9): 1
+
+--- Check In Visitor ---
+Enter visitor name: Kureshu pujari
+Enter phone number: 7893285837
+
+ Visitor checked in successfully!
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
+4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
+============================
+Enter your choice (1-9): 1
+
+--- Check In Visitor ---
+Enter visitor name: Kalyni Kumari
+Enter phone number: 7943258384
+
+ Visitor checked in successfully!
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
+4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
+============================
+Enter your choice (1-9): 1
+
+--- Check In Visitor ---
+Enter visitor name: Pravanjan Khutia
+Enter phone number: 7943253290
+
+ Visitor checked in successfully!
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
+4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
+============================
+Enter your choice (1-9): 5
+
+=== ON SITE NOW (Total: 3) ===
+1    | Kureshu pujari       | 7893285837      | 2026-01-13 22:42:36 | on site
+2    | Kalyni Kumari        | 7943258384      | 2026-01-13 22:43:08 | on site
+3    | Pravanjan Khutia     | 7943253290      | 2026-01-13 22:43:38 | on site
+Enter visitor ID to check out: 2
+
+ Visitor checked out successfully!
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
+4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
+============================
+Enter your choice (1-9): 2
+
+=== VISITOR REGISTER (Total: 3) ===
+ID   | NAME                 | PHONE           | CHECK-IN            | CHECK-OUT
+------------------------------------------------------------------------------------
+1    | Kureshu pujari       | 7893285837      | 2026-01-13 22:42:36 | on site
+2    | Kalyni Kumari        | 7943258384      | 2026-01-13 22:43:08 | 2026-01-13 23:05:12
+3    | Pravanjan Khutia     | 7943253290      | 2026-01-13 22:43:38 | on site
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
+4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
+============================
+Enter your choice (1-9): 3
+
+ Data saved successfully!
+
+=========== MENU ===========
+1. Check In Visitor
+2. View All Visitors
+3. Save Data
 4. Exit
+5. Check Out Visitor
+6. Who Is On Site Now
+7. Visitors Between Times
+8. Occupancy Per Hour
+9. Remove Old Visits
 ============================
-Enter your choice (1-4): 4
+Enter your choice (1-9): 4
 
  Thank you for using Visitor Management System!
 */